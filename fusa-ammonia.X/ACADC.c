@@ -0,0 +1,131 @@
+#include "ACADC.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "application.h"
+#include "SENSOR.h"
+#include "TIMING.h"
+#include "ACTEST.h"
+#include "CPUCLK.h"
+
+#if (ACADC_CHANNEL >= SENSOR_CHANNEL_COUNT)
+#error ACADC_CHANNEL is not a sensor channel
+#endif
+
+static uint16_t lastResult = 0;
+static uint16_t diffMax = 0;
+static uint8_t mismatchCount = 0;
+
+//Execution time
+static uint16_t measureTime = 0;
+static uint16_t measureTimeMax = 0;
+
+//Returns true if DAC0 is above the sensor
+static bool _isDACAbove(void)
+{
+    bool state = ((AC1.STATUS & AC_CMPSTATE_bm) != 0);
+    bool isInverted = ((AC1.MUXCTRL & AC_INVERT_bm) != 0);
+
+    return (state != isInverted);
+}
+
+//Measures the sensor voltage with DAC0 and AC1, returns ADC0 counts (blocking, about 100us)
+uint16_t ACADC_Measure(void)
+{
+    uint32_t start = TIMING_TimestampGet();
+
+    //Settling time of the comparator test, tightened by characterisation
+    uint8_t settle = ACTEST_SettleGet(ACADC_CHANNEL);
+
+    //DAC0 on In+, the sensor on In-
+    uint8_t muxctrl = AC1.MUXCTRL;
+    AC1.MUXCTRL = (muxctrl & ~(AC_MUXPOS_gm | AC_MUXNEG_gm)) |
+            SENSOR_ChannelConfigGet(ACADC_CHANNEL)->acDACMux | ACADC_SENSOR_MUXNEG;
+
+    //Largest code at or below the sensor
+    uint16_t code = 0;
+    for (uint16_t bit = 0x200; bit != 0; bit >>= 1)
+    {
+        DAC0_SetOutput(code | bit);
+        CPUCLK_DelayMicroseconds(settle);
+
+        if (!_isDACAbove())
+        {
+            code |= bit;
+        }
+    }
+
+    AC1.MUXCTRL = muxctrl;
+
+    //Middle of the DAC0 step, 10-bit to 12-bit
+    lastResult = (code << 2) + 2;
+
+    measureTime = (uint16_t) TIMING_TICKS_TO_US(TIMING_ElapsedGet(start));
+    if (measureTime > measureTimeMax)
+    {
+        measureTimeMax = measureTime;
+    }
+
+    return lastResult;
+}
+
+//Measures the sensor voltage, and compares it with the ADC0 reading of the same tick
+diag_result_t ACADC_Verify(uint16_t adcResult)
+{
+    //The comparator test is using DAC0
+    if (ACTEST_IsRunning())
+    {
+        return DIAG_PASS;
+    }
+
+    uint16_t result = ACADC_Measure();
+    uint16_t diff = (result > adcResult) ? (result - adcResult) : (adcResult - result);
+
+    if (diff > diffMax)
+    {
+        diffMax = diff;
+    }
+
+    if (diff <= ACADC_MISMATCH_MAX)
+    {
+        mismatchCount = 0;
+        return DIAG_PASS;
+    }
+
+    //The sensor may move between the two measurements, a single mismatch is not a failure
+    if (mismatchCount < ACADC_MISMATCH_COUNT)
+    {
+        mismatchCount++;
+    }
+
+    return (mismatchCount >= ACADC_MISMATCH_COUNT) ? DIAG_FAIL : DIAG_PASS;
+}
+
+//Returns the last measurement (ADC0 counts)
+uint16_t ACADC_LastGet(void)
+{
+    return lastResult;
+}
+
+//Returns the execution time of the last measurement (us)
+uint16_t ACADC_TimeGet(void)
+{
+    return measureTime;
+}
+
+//Returns the execution time of the slowest measurement (us)
+uint16_t ACADC_TimeMaxGet(void)
+{
+    return measureTimeMax;
+}
+
+//Prints the last measurement, the largest difference from ADC0 and the execution time
+void ACADC_StatsPrint(void)
+{
+    printf("AC1 / DAC0 measurement: %u (max difference %u, limit %u), time = %u us (worst %u us)\r\n",
+            lastResult, diffMax, ACADC_MISMATCH_MAX, measureTime, measureTimeMax);
+}
@@ -0,0 +1,79 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef ACADC_H
+#define	ACADC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+/* Diverse sensor measurement (FUSA_ENABLE_AC_ADC in application.h)
+ * 
+ * AC1 compares DAC0 (In+) with the sensor (In-), and DAC0 is stepped as a 10-bit
+ * successive approximation. The result is an independent measurement of the sensor
+ * voltage, compared with the ADC0 reading of the same tick.
+ * 
+ * DAC0 and ADC0 both use the 2.048V reference, one DAC0 LSB is 4 ADC0 counts.
+ * 
+ * AC1 In- is normally DACREF (the alarm threshold), so the sensor must also be
+ * connected to the AINN pin selected by ACADC_SENSOR_MUXNEG.
+ * AC1 is not watching the alarm threshold during the measurement.
+ */
+    
+//Sensor channel on AC1
+#define ACADC_CHANNEL 0
+    
+//AC1 negative input wired to the sensor
+#define ACADC_SENSOR_MUXNEG AC_MUXNEG_AINN0_gc
+    
+//Max difference from ADC0 (ADC0 counts)
+#define ACADC_MISMATCH_MAX 64
+    
+//Consecutive mismatches before the check fails
+#define ACADC_MISMATCH_COUNT 3
+    
+    //Measures the sensor voltage with DAC0 and AC1, returns ADC0 counts (blocking, about 100us)
+    uint16_t ACADC_Measure(void);
+    
+    //Measures the sensor voltage, and compares it with the ADC0 reading of the same tick
+    diag_result_t ACADC_Verify(uint16_t adcResult);
+    
+    //Returns the last measurement (ADC0 counts)
+    uint16_t ACADC_LastGet(void);
+    
+    //Returns the execution time of the last / slowest measurement (us)
+    uint16_t ACADC_TimeGet(void);
+    uint16_t ACADC_TimeMaxGet(void);
+    
+    //Prints the last measurement, the largest difference from ADC0 and the execution time
+    void ACADC_StatsPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ACADC_H */
@@ -0,0 +1,304 @@
+#include "ACCHAR.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "application.h"
+#include "fusa.h"
+#include "SENSOR.h"
+#include "TIMING.h"
+#include "ACTEST.h"
+#include "CPUCLK.h"
+
+#if (ACCHAR_CHANNEL >= SENSOR_CHANNEL_COUNT)
+#error ACCHAR_CHANNEL is not a sensor channel
+#endif
+
+//Boundaries of the comparator test acceptance, an offset of TEST_MARGIN still passes
+#if !ACTEST_IS_OFFSET_PASS(TEST_MARGIN, TEST_MARGIN) || ACTEST_IS_OFFSET_PASS(TEST_MARGIN + 1, TEST_MARGIN) || \
+        !ACTEST_IS_OFFSET_PASS(1 - TEST_MARGIN, TEST_MARGIN) || ACTEST_IS_OFFSET_PASS(-TEST_MARGIN, TEST_MARGIN)
+#error ACTEST_IS_OFFSET_PASS does not match the comparator test
+#endif
+
+//Trend log, the first entry is the baseline
+static acchar_result_t trend[ACCHAR_TREND_SIZE];
+static uint8_t trendIndex = 0;
+static uint16_t runCount = 0;
+
+static acchar_result_t baseline;
+static bool isDrifting = false;
+static uint16_t runTime = 0;
+
+//Sets DAC0, waits, then returns the AC1 output
+static bool _stateGet(uint16_t code)
+{
+    DAC0_SetOutput(code);
+    CPUCLK_DelayMicroseconds(ACCHAR_SAR_SETTLE_US);
+
+    return ((AC1.STATUS & AC_CMPSTATE_bm) != 0);
+}
+
+//Finds the first DAC0 code where AC1 changes state, returns 0 if the output is stuck
+static uint16_t _tripFind(void)
+{
+    bool lowState = _stateGet(0);
+
+    if (_stateGet(0x3FF) == lowState)
+    {
+        return 0;
+    }
+
+    //Largest code still in the low state
+    uint16_t code = 0;
+    for (uint16_t bit = 0x200; bit != 0; bit >>= 1)
+    {
+        if (_stateGet(code | bit) == lowState)
+        {
+            code |= bit;
+        }
+    }
+
+    return code + 1;
+}
+
+//Measures the time from a DAC0 step to the AC1 output edge, returns 0 if there is no edge
+static uint16_t _responseMeasure(uint16_t from, uint16_t to)
+{
+    DAC0_SetOutput(from);
+    CPUCLK_DelayMicroseconds(ACCHAR_STEP_SETTLE_US);
+
+    //Capture the edge away from the current output
+    ACCHAR_TCB.CTRLA = 0;
+    ACCHAR_TCB.EVCTRL = TCB_CAPTEI_bm | ((AC1.STATUS & AC_CMPSTATE_bm) ? TCB_EDGE_bm : 0);
+    ACCHAR_TCB.CNT = 0;
+    ACCHAR_TCB.INTFLAGS = TCB_CAPT_bm;
+
+    uint16_t start;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ACCHAR_TCB.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm;
+
+        //Read before the step, so the result is never short
+        start = ACCHAR_TCB.CNT;
+        DAC0_SetOutput(to);
+    }
+
+    //TCB0 counts CLK_PER, which may be boosted
+    uint8_t scale = CPUCLK_ScaleGet();
+
+    while (!(ACCHAR_TCB.INTFLAGS & TCB_CAPT_bm))
+    {
+        if (ACCHAR_TCB.CNT > (ACCHAR_TIMEOUT_TICKS * scale))
+        {
+            ACCHAR_TCB.CTRLA = 0;
+            return 0;
+        }
+    }
+
+    ACCHAR_TCB.CTRLA = 0;
+
+    //Ticks at F_CPU, comparable with the trend log
+    uint16_t ticks = (ACCHAR_TCB.CCMP - start) / scale;
+    return (ticks == 0) ? 1 : ticks;
+}
+
+//Returns the worst response time of a step, 0 if any step had no edge
+static uint16_t _responseWorstGet(uint16_t from, uint16_t to)
+{
+    uint16_t worst = 0;
+
+    for (uint8_t i = 0; i < ACCHAR_RESPONSE_SAMPLES; i++)
+    {
+        uint16_t ticks = _responseMeasure(from, to);
+
+        if (ticks == 0)
+        {
+            return 0;
+        }
+        else if (ticks > worst)
+        {
+            worst = ticks;
+        }
+    }
+
+    return worst;
+}
+
+//Compares a result with the baseline
+static bool _isDrifted(const acchar_result_t* result)
+{
+    //The offset depends on the setpoint
+    if ((result->dacref == baseline.dacref) && (abs(result->offset - baseline.offset) > ACCHAR_OFFSET_DRIFT_MAX))
+    {
+        return true;
+    }
+
+    uint32_t limitRise = baseline.rise + ((baseline.rise * (uint32_t) ACCHAR_RESPONSE_DRIFT_PCT) / 100UL);
+    uint32_t limitFall = baseline.fall + ((baseline.fall * (uint32_t) ACCHAR_RESPONSE_DRIFT_PCT) / 100UL);
+
+    return ((result->rise > limitRise) || (result->fall > limitFall));
+}
+
+//Routes the AC1 output to the capture input of TCB0
+void ACCHAR_Initialize(void)
+{
+    //Replaces the MCC set-up of TCB0
+    ACCHAR_TCB.CTRLA = 0;
+    ACCHAR_TCB.CTRLB = TCB_CNTMODE_CAPT_gc;
+    ACCHAR_TCB.INTCTRL = 0;
+    ACCHAR_TCB.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+
+    EVSYS.ACCHAR_EVSYS_CHANNEL = ACCHAR_EVSYS_GENERATOR;
+    EVSYS.USERTCB0CAPT = ACCHAR_EVSYS_USER;
+}
+
+//Characterises AC1, then tightens the comparator test (blocking, about 1ms)
+diag_result_t ACCHAR_Run(void)
+{
+    if (ACTEST_IsRunning())
+    {
+        return DIAG_UNDEFINED;
+    }
+
+    uint32_t start = TIMING_TimestampGet();
+    diag_result_t status = DIAG_PASS;
+
+    acchar_result_t result;
+    result.run = runCount;
+
+    //Blind window starts
+    APP_DACConnect(ACCHAR_CHANNEL);
+
+    result.dacref = APP_DACREFGet(ACCHAR_CHANNEL);
+    result.trip = _tripFind();
+    result.offset = ((int16_t) result.trip) - (result.dacref << 2);
+
+    if ((result.trip == 0) || (result.trip > 0x3FF))
+    {
+        //Output stuck, or not monotonic
+        status = DIAG_FAIL;
+        result.rise = 0;
+        result.fall = 0;
+    }
+    else
+    {
+        //Worst case steps of the comparator test
+        uint16_t high = result.trip + TEST_MARGIN;
+        uint16_t low = (result.trip > TEST_MARGIN) ? (result.trip - TEST_MARGIN) : 0;
+
+        if (high > 0x3FF)
+        {
+            high = 0x3FF;
+        }
+
+        result.rise = _responseWorstGet(0, high);
+        result.fall = _responseWorstGet(0x3FF, low);
+    }
+
+    //Blind window ends
+    APP_SensorConnect(ACCHAR_CHANNEL);
+
+    runTime = (uint16_t) TIMING_TICKS_TO_US(TIMING_ElapsedGet(start));
+
+    if (status != DIAG_PASS)
+    {
+        return status;
+    }
+
+    //No edge, or slower than the comparator test allows
+    uint16_t worst = (result.rise > result.fall) ? result.rise : result.fall;
+    if ((result.rise == 0) || (result.fall == 0) ||
+            (ACCHAR_TICKS_TO_NS(worst) > (ACTEST_SETTLE_US * 1000UL)))
+    {
+        return DIAG_FAIL;
+    }
+
+    //The comparator test would not pass with its default margin
+    if (!ACTEST_IS_OFFSET_PASS(result.offset, TEST_MARGIN))
+    {
+        return DIAG_FAIL;
+    }
+
+    //Twice the worst response time, rounded up
+    uint8_t offset = (uint8_t) abs(result.offset);
+    uint8_t settle = (uint8_t) (((2UL * ACCHAR_TICKS_TO_NS(worst)) + 999UL) / 1000UL);
+    ACTEST_ChannelTune(ACCHAR_CHANNEL, offset + ACCHAR_MARGIN_GUARD, result.dacref, settle);
+
+    //Trend log
+    if (runCount == 0)
+    {
+        baseline = result;
+    }
+
+    isDrifting = _isDrifted(&result);
+
+    trend[trendIndex] = result;
+    trendIndex = (trendIndex + 1) % ACCHAR_TREND_SIZE;
+
+    if (runCount < UINT16_MAX)
+    {
+        runCount++;
+    }
+
+    return DIAG_PASS;
+}
+
+//Returns true if the last result has drifted from the first result
+bool ACCHAR_IsDrifting(void)
+{
+    return isDrifting;
+}
+
+//Returns true if the last result was measured at the current DACREF
+bool ACCHAR_IsSetpointCharacterized(void)
+{
+    return (runCount != 0) && (ACCHAR_LastGet()->dacref == APP_DACREFGet(ACCHAR_CHANNEL));
+}
+
+//Returns the last result
+const acchar_result_t* ACCHAR_LastGet(void)
+{
+    return &trend[(trendIndex + ACCHAR_TREND_SIZE - 1) % ACCHAR_TREND_SIZE];
+}
+
+//Returns the execution time of the last characterisation (us)
+uint16_t ACCHAR_RunTimeGet(void)
+{
+    return runTime;
+}
+
+//Prints the trend log
+void ACCHAR_TrendPrint(void)
+{
+    if (runCount == 0)
+    {
+        printf("AC1 not characterised\r\n");
+        return;
+    }
+
+    printf("AC1 characterisation (%u us):\r\n", runTime);
+
+    //Oldest first
+    uint8_t count = (runCount < ACCHAR_TREND_SIZE) ? (uint8_t) runCount : ACCHAR_TREND_SIZE;
+    uint8_t index = (trendIndex + ACCHAR_TREND_SIZE - count) % ACCHAR_TREND_SIZE;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const acchar_result_t* result = &trend[index];
+        printf("#%u: DACREF = 0x%x, trip = %u, offset = %d LSB, rise = %lu ns, fall = %lu ns\r\n",
+                result->run, result->dacref, result->trip, result->offset,
+                ACCHAR_TICKS_TO_NS(result->rise), ACCHAR_TICKS_TO_NS(result->fall));
+
+        index = (index + 1) % ACCHAR_TREND_SIZE;
+    }
+
+    printf("Baseline: DACREF = 0x%x, offset = %d LSB, rise = %lu ns, fall = %lu ns%s\r\n",
+            baseline.dacref, baseline.offset, ACCHAR_TICKS_TO_NS(baseline.rise), ACCHAR_TICKS_TO_NS(baseline.fall),
+            (isDrifting) ? ", DRIFTING" : "");
+}
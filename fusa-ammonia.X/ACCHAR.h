@@ -0,0 +1,123 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef ACCHAR_H
+#define	ACCHAR_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+/* AC1 characterisation
+ * 
+ * Trip point: DAC0 is connected to In+ and stepped as a 10-bit successive approximation,
+ * the first code where AC1 changes state is the trip point. The offset is the trip point
+ * minus DACREF (scaled to 10-bit).
+ * 
+ * Response time: DAC0 is stepped across the trip point, TCB0 counts from the step
+ * until it captures the AC1 output edge (AC1 -> EVSYS -> TCB0). The worst case step
+ * (from either end of the DAC0 range) includes DAC0 settling.
+ * 
+ * The results tighten the margin and settling time of the periodic comparator test (ACTEST),
+ * and are kept in a trend log. A shift from the first result after power-up is reported as drift.
+ * 
+ * The offset includes the INL of DACREF and DAC0 at the setpoint, so it only tightens the margin
+ * at the DACREF it was measured at. A new setpoint (calibration, environment compensation) is
+ * characterised again within the hour, and the offset drift is only compared at the same DACREF.
+ */
+    
+//Sensor channel on AC1 (the TCB0 capture only works on AC1)
+#define ACCHAR_CHANNEL 0
+    
+//Capture timer, and event channel from the AC1 output (TCB0 is not used by MCC)
+#define ACCHAR_TCB TCB0
+#define ACCHAR_EVSYS_CHANNEL CHANNEL1
+#define ACCHAR_EVSYS_GENERATOR EVSYS_CHANNEL1_AC1_OUT_gc
+#define ACCHAR_EVSYS_USER EVSYS_USER_CHANNEL1_gc
+    
+//TCB0 runs from CLK_PER (3.33 MHz) - 300ns per tick, captures are converted to these ticks when CLK_PER is boosted
+#define ACCHAR_TICKS_TO_NS(ticks) (((uint32_t) (ticks)) * 300UL)
+    
+//No edge within this time is a failure (ticks)
+#define ACCHAR_TIMEOUT_TICKS 333
+    
+//Wait for each successive approximation step (us)
+#define ACCHAR_SAR_SETTLE_US 20
+    
+//Wait before a response time measurement (us)
+#define ACCHAR_STEP_SETTLE_US 50
+    
+//Response time measurements per edge
+#define ACCHAR_RESPONSE_SAMPLES 4
+    
+//Margin added to the measured offset for the comparator test (DAC0 LSB)
+#define ACCHAR_MARGIN_GUARD 2
+    
+//Drift from the first result that is reported (DAC0 LSB, % of the response time)
+#define ACCHAR_OFFSET_DRIFT_MAX 2
+#define ACCHAR_RESPONSE_DRIFT_PCT 50
+    
+//Characterisation period while monitoring (hours)
+#define ACCHAR_PERIOD_HOURS 24
+    
+//Results kept in the trend log
+#define ACCHAR_TREND_SIZE 8
+    
+    typedef struct {
+        uint16_t run;           //Characterisation number since power-up
+        uint16_t trip;          //First DAC0 code past the trip point
+        int16_t offset;         //Trip point - DACREF (DAC0 LSB)
+        uint8_t dacref;         //DACREF the trip point was measured at
+        uint16_t rise;          //Worst response time, DAC0 rising (ticks)
+        uint16_t fall;          //Worst response time, DAC0 falling (ticks)
+    } acchar_result_t;
+    
+    //Routes the AC1 output to the capture input of TCB0
+    void ACCHAR_Initialize(void);
+    
+    //Characterises AC1, then tightens the comparator test (blocking, about 1ms)
+    diag_result_t ACCHAR_Run(void);
+    
+    //Returns true if the last result has drifted from the first result
+    bool ACCHAR_IsDrifting(void);
+    
+    //Returns true if the last result was measured at the current DACREF
+    bool ACCHAR_IsSetpointCharacterized(void);
+    
+    //Returns the last result
+    const acchar_result_t* ACCHAR_LastGet(void);
+    
+    //Returns the execution time of the last characterisation (us)
+    uint16_t ACCHAR_RunTimeGet(void);
+    
+    //Prints the trend log
+    void ACCHAR_TrendPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ACCHAR_H */
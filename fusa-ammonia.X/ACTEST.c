@@ -0,0 +1,312 @@
+#include "ACTEST.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "application.h"
+#include "fusa.h"
+#include "SENSOR.h"
+#include "TIMING.h"
+#include "CPUCLK.h"
+#include "ALARM.h"
+
+//Step of the test waiting for the timer
+typedef enum {
+    ACTEST_IDLE = 0, ACTEST_HIGH, ACTEST_LOW
+} actest_phase_t;
+
+static volatile actest_phase_t phase = ACTEST_IDLE;
+static volatile uint8_t channel = 0;
+static volatile diag_result_t result = DIAG_UNDEFINED;
+
+//Blind window
+static uint32_t disconnectTime = 0;
+static volatile uint16_t blindTime = 0;
+static volatile uint16_t blindTimeMax = 0;
+
+//Test margin (DAC0 LSB) and settling time (us, timer ticks) of each channel, tightened by characterisation
+//The margin was measured at marginDACREF
+static uint8_t testMargin[SENSOR_CHANNEL_COUNT];
+static uint8_t marginDACREF[SENSOR_CHANNEL_COUNT];
+static uint8_t settleTime[SENSOR_CHANNEL_COUNT];
+static uint16_t settleTicks[SENSOR_CHANNEL_COUNT];
+
+//Waits for the settling time of the channel, then runs the next phase
+static void _timerStart(void)
+{
+    ACTEST_TCB.CTRLA = 0;
+    ACTEST_TCB.CNT = 0;
+    ACTEST_TCB.INTFLAGS = TCB_CAPT_bm;
+    ACTEST_TCB.CTRLA = ACTEST_TCB_CLKSEL | TCB_ENABLE_bm;
+}
+
+//Returns the margin of a channel, the default unless it was characterised at the current DACREF
+static uint8_t _marginGet(uint8_t ch)
+{
+    return (APP_DACREFGet(ch) == marginDACREF[ch]) ? testMargin[ch] : TEST_MARGIN;
+}
+
+//Re-arms the hardware alarm path once every channel is back on its sensor
+static void _alarmRestore(void)
+{
+#ifdef FUSA_ENABLE_HW_ALARM
+    system_state_t state = FUSA_SystemStateGet();
+    ALARM_Arm((state == SYS_MONITOR) || (state == SYS_ALARM));
+#endif
+}
+
+//Connects a channel to DAC0, above DACREF
+static void _channelStart(uint8_t ch)
+{
+    channel = ch;
+
+    //TCB3 counts CLK_PER, which may be boosted
+    ACTEST_TCB.CCMP = settleTicks[ch] * CPUCLK_ScaleGet();
+
+#ifdef FUSA_ENABLE_HW_ALARM
+    //DACREF + margin trips AC1, keep the buzzer quiet
+    ALARM_Arm(false);
+#endif
+
+    APP_DACConnect(ch);
+    disconnectTime = TIMING_TimestampGet();
+
+    //DAC0 is 10-bit, DACREF is 8-bit
+    int16_t testVal = (APP_DACREFGet(ch) << 2) + _marginGet(ch);
+    if (testVal >= 0x3FF)
+    {
+        testVal = 0x3FF;
+    }
+
+    DAC0_SetOutput(testVal);
+
+    phase = ACTEST_HIGH;
+    _timerStart();
+}
+
+//Reconnects the channel to its sensor, then tests the next channel
+static void _channelEnd(bool isPass)
+{
+    APP_SensorConnect(channel);
+
+    uint16_t time = (uint16_t) TIMING_TICKS_TO_US(TIMING_ElapsedGet(disconnectTime));
+    blindTime = (channel == 0) ? time : (blindTime + time);
+    if (time > blindTimeMax)
+    {
+        blindTimeMax = time;
+    }
+
+    if (!isPass)
+    {
+        phase = ACTEST_IDLE;
+        result = DIAG_FAIL;
+        _alarmRestore();
+    }
+    else if ((channel + 1) < SENSOR_CHANNEL_COUNT)
+    {
+        _channelStart(channel + 1);
+    }
+    else
+    {
+        phase = ACTEST_IDLE;
+        result = DIAG_PASS;
+        _alarmRestore();
+    }
+}
+
+//Runs the phase waiting for the timer
+static void _phaseRun(void)
+{
+    ACTEST_TCB.CTRLA = 0;
+    ACTEST_TCB.INTFLAGS = TCB_CAPT_bm;
+
+    AC_t* ac = SENSOR_ChannelConfigGet(channel)->ac;
+
+    if (phase == ACTEST_HIGH)
+    {
+        //Is the signal HIGH?
+        if (ac->STATUS & AC_CMPSTATE_bm)
+        {
+            _channelEnd(false);
+            return;
+        }
+
+        //Set to DACREF - margin
+        int16_t testVal = (APP_DACREFGet(channel) << 2) - _marginGet(channel);
+        if (testVal < 0)
+        {
+            testVal = 0;
+        }
+
+        DAC0_SetOutput(testVal);
+
+        phase = ACTEST_LOW;
+        _timerStart();
+    }
+    else if (phase == ACTEST_LOW)
+    {
+        //Is the signal LOW?
+        _channelEnd((ac->STATUS & AC_CMPSTATE_bm) != 0);
+    }
+}
+
+ISR(TCB3_INT_vect)
+{
+    _phaseRun();
+}
+
+//Sets up the timer as a one-shot
+static void _timerInitialize(bool useInterrupt)
+{
+    ACTEST_TCB.CTRLA = 0;
+    ACTEST_TCB.CTRLB = TCB_CNTMODE_INT_gc;
+    ACTEST_TCB.INTFLAGS = TCB_CAPT_bm;
+    ACTEST_TCB.INTCTRL = useInterrupt ? TCB_CAPT_bm : 0;
+}
+
+//Sets the default margin and settling time of every channel
+void ACTEST_Initialize(void)
+{
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        testMargin[ch] = TEST_MARGIN;
+        marginDACREF[ch] = 0;
+        settleTime[ch] = ACTEST_SETTLE_US;
+        settleTicks[ch] = (uint16_t) TIMING_US_TO_TICKS(ACTEST_SETTLE_US);
+    }
+}
+
+//Starts the test of every channel in the background, unless one is running
+void ACTEST_Start(void)
+{
+    if (phase != ACTEST_IDLE)
+    {
+        return;
+    }
+
+    result = DIAG_UNDEFINED;
+    _timerInitialize(true);
+    _channelStart(0);
+}
+
+//Runs the test of every channel to completion, without interrupts (for the start-up self-test)
+diag_result_t ACTEST_Run(void)
+{
+    if (phase != ACTEST_IDLE)
+    {
+        return DIAG_FAIL;
+    }
+
+    result = DIAG_UNDEFINED;
+    _timerInitialize(false);
+    _channelStart(0);
+
+    uint32_t start = TIMING_TimestampGet();
+
+    while (phase != ACTEST_IDLE)
+    {
+        if (ACTEST_TCB.INTFLAGS & TCB_CAPT_bm)
+        {
+            _phaseRun();
+        }
+        else if (TIMING_ElapsedGet(start) > TIMING_US_TO_TICKS(100UL * ACTEST_SETTLE_US))
+        {
+            //Timer is not running
+            ACTEST_TCB.CTRLA = 0;
+            _channelEnd(false);
+        }
+    }
+
+    return result;
+}
+
+//Returns DIAG_PASS / DIAG_FAIL for the last test, DIAG_FAIL if still running, DIAG_UNDEFINED if none was started
+diag_result_t ACTEST_ResultGet(void)
+{
+    //Every phase completes within microseconds, a test still running has stalled
+    if (phase != ACTEST_IDLE)
+    {
+        return DIAG_FAIL;
+    }
+
+    return result;
+}
+
+//Returns true while a background test is running
+bool ACTEST_IsRunning(void)
+{
+    return (phase != ACTEST_IDLE);
+}
+
+//Tightens the margin (DAC0 LSB) at a DACREF, and the settling time (us) of a channel, limited to the defaults
+void ACTEST_ChannelTune(uint8_t ch, uint8_t margin, uint8_t dacref, uint8_t settleUs)
+{
+    if (margin > TEST_MARGIN)
+    {
+        margin = TEST_MARGIN;
+    }
+    else if (margin == 0)
+    {
+        margin = 1;
+    }
+
+    if (settleUs > ACTEST_SETTLE_US)
+    {
+        settleUs = ACTEST_SETTLE_US;
+    }
+    else if (settleUs < ACTEST_SETTLE_MIN_US)
+    {
+        settleUs = ACTEST_SETTLE_MIN_US;
+    }
+
+    //Not while the timer is using them
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        testMargin[ch] = margin;
+        marginDACREF[ch] = dacref;
+        settleTime[ch] = settleUs;
+        settleTicks[ch] = (uint16_t) TIMING_US_TO_TICKS(settleUs);
+    }
+}
+
+//Returns the margin of a channel at its current DACREF (DAC0 LSB)
+uint8_t ACTEST_MarginGet(uint8_t ch)
+{
+    return _marginGet(ch);
+}
+
+//Returns the settling time of a channel (us)
+uint8_t ACTEST_SettleGet(uint8_t ch)
+{
+    return settleTime[ch];
+}
+
+//Returns the time the comparators were disconnected from the sensors in the last test (us)
+uint16_t ACTEST_BlindTimeGet(void)
+{
+    return blindTime;
+}
+
+//Returns the longest time a comparator was disconnected from its sensor (us)
+uint16_t ACTEST_BlindTimeMaxGet(void)
+{
+    return blindTimeMax;
+}
+
+//Prints the blind window of the comparator test
+void ACTEST_StatsPrint(void)
+{
+    printf("AC test: sensors disconnected for %u us (worst %u us per channel)\r\n",
+            blindTime, blindTimeMax);
+
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        printf("CH%u: margin = %u LSB, settle = %u us\r\n",
+                ch, _marginGet(ch), ACTEST_SettleGet(ch));
+    }
+}
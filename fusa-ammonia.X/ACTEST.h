@@ -0,0 +1,101 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef ACTEST_H
+#define	ACTEST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+//Timer of the split-phase comparator test, same clock as the TIMING timebase (at F_CPU)
+#define ACTEST_TCB TCB3
+#define ACTEST_TCB_CLKSEL TCB_CLKSEL_DIV2_gc
+    
+//Wait for DAC0 to settle (7us) and the AC to respond (0.15us)
+#define ACTEST_SETTLE_US 8
+    
+//Shortest settling time allowed after characterisation (us)
+#define ACTEST_SETTLE_MIN_US 2
+    
+//If defined, the blind window is printed every hour
+//#define PRINT_AC_TEST_STATS
+    
+    /* Comparator test, per channel:
+     * 1. Switch In+ to DAC0, set DAC0 above DACREF   (blind window starts)
+     * 2. After the settling time, check the output is LOW, set DAC0 below DACREF
+     * 3. After the settling time, check the output is HIGH
+     * 4. Switch In+ back to the sensor               (blind window ends)
+     * 
+     * Steps 2 - 4 run from the ACTEST_TCB interrupt, so the CPU is free while DAC0 settles
+     * 
+     * The margin starts at TEST_MARGIN and the settling time at ACTEST_SETTLE_US,
+     * characterisation (ACCHAR) can tighten both. The tightened margin only applies at the
+     * DACREF it was measured at, other setpoints are tested with TEST_MARGIN
+     */
+    
+//True if a trip point offset (DAC0 LSB) passes the test with a margin:
+//not tripped at DACREF + margin, tripped at DACREF - margin
+#define ACTEST_IS_OFFSET_PASS(offset, margin) (((offset) <= (margin)) && ((offset) > -(margin)))
+    
+    //Sets the default margin and settling time of every channel
+    void ACTEST_Initialize(void);
+    
+    //Starts the test of every channel in the background, unless one is running
+    void ACTEST_Start(void);
+    
+    //Runs the test of every channel to completion, without interrupts (for the start-up self-test)
+    diag_result_t ACTEST_Run(void);
+    
+    //Returns DIAG_PASS / DIAG_FAIL for the last test, DIAG_FAIL if still running, DIAG_UNDEFINED if none was started
+    diag_result_t ACTEST_ResultGet(void);
+    
+    //Returns true while a background test is running
+    bool ACTEST_IsRunning(void);
+    
+    //Tightens the margin (DAC0 LSB) at a DACREF, and the settling time (us) of a channel, limited to the defaults
+    void ACTEST_ChannelTune(uint8_t ch, uint8_t margin, uint8_t dacref, uint8_t settleUs);
+    
+    //Returns the margin of a channel at its current DACREF (DAC0 LSB)
+    uint8_t ACTEST_MarginGet(uint8_t ch);
+    
+    //Returns the settling time of a channel (us)
+    uint8_t ACTEST_SettleGet(uint8_t ch);
+    
+    //Returns the time the comparators were disconnected from the sensors in the last test (us)
+    uint16_t ACTEST_BlindTimeGet(void);
+    
+    //Returns the longest time a comparator was disconnected from its sensor (us)
+    uint16_t ACTEST_BlindTimeMaxGet(void);
+    
+    //Prints the blind window of the comparator test
+    void ACTEST_StatsPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ACTEST_H */
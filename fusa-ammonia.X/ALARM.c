@@ -0,0 +1,193 @@
+#include "ALARM.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "SENSOR.h"
+#include "HEATER.h"
+
+//Mode of the hardware path
+#define ALARM_MODE_ARMED 0x01
+#define ALARM_MODE_FORCED 0x02
+
+//LUT2 output pin
+#define ALARM_PIN_bm PIN3_bm
+
+//CMP2 above PER is a constant high WO2
+#define ALARM_FORCE_ON (HEATER_PWM_PER + 1)
+#define ALARM_FORCE_OFF 0
+
+//LUT2 configuration
+#define ALARM_LUT_CTRLA (CCL_OUTEN_bm | CCL_ENABLE_bm)
+#define ALARM_LUT_CTRLB (CCL_INSEL0_EVENTA_gc | CCL_INSEL1_TCA0_gc)
+#define ALARM_LUT_CTRLC (CCL_INSEL2_TCA0_gc)
+
+//Truth table (index = IN2:IN1:IN0) - the tone passes if AC1 is tripped (IN0) or forced (IN2)
+#define ALARM_TRUTH_TRIP_LOW 0xC4
+#define ALARM_TRUTH_TRIP_HIGH 0xC8
+#define ALARM_TRUTH ((GAS_SENSOR_LOGIC_TRIPPED) ? ALARM_TRUTH_TRIP_HIGH : ALARM_TRUTH_TRIP_LOW)
+
+//Mode, and its complement for verification
+static uint8_t mode = 0;
+static uint8_t modeCheck = 0xFF;
+
+//Tone compare value configured by MCC
+static uint8_t toneCompare = 0;
+
+//Updates the TCA0 compares gating the tone
+static void _modeApply(uint8_t newMode)
+{
+    mode = newMode;
+    modeCheck = ~newMode;
+
+    uint8_t tone = (mode != 0) ? toneCompare : 0;
+    uint8_t force = (mode & ALARM_MODE_FORCED) ? ALARM_FORCE_ON : ALARM_FORCE_OFF;
+
+    //Written directly, so disarming does not wait for the end of the PWM period
+    TCA0.SINGLE.CMP1 = tone;
+    TCA0.SINGLE.CMP1BUF = tone;
+    TCA0.SINGLE.CMP2 = force;
+    TCA0.SINGLE.CMP2BUF = force;
+}
+
+//Returns true if AC1 is tripped
+static bool _isTripped(void)
+{
+    return (((AC1.STATUS & AC_CMPSTATE_bm) != 0) == GAS_SENSOR_LOGIC_TRIPPED);
+}
+
+//Samples the LUT2 output once, with the TCA0 count before and after
+//Returns false if the count changed, or is on a WO1 edge (BOTTOM or CMP1), so the tone phase is unknown
+static bool _outputSample(bool* isHigh, bool* isTonePhase)
+{
+    uint16_t before;
+    uint16_t after;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        before = TCA0.SINGLE.CNT;
+        *isHigh = ((VPORTD.IN & ALARM_PIN_bm) != 0);
+        after = TCA0.SINGLE.CNT;
+    }
+
+    if ((before != after) || (before == 0) || (before == toneCompare))
+    {
+        return false;
+    }
+
+    //Single-slope PWM, WO1 is high from BOTTOM until CMP1
+    *isTonePhase = (before < toneCompare);
+    return true;
+}
+
+//Routes AC1 to the buzzer through EVSYS and the CCL, disarmed and not forced
+void ALARM_Initialize(void)
+{
+    toneCompare = (uint8_t) TCA0.SINGLE.CMP1;
+    _modeApply(0);
+
+    //WO1 no longer drives the buzzer pin
+    TCA0.SINGLE.CTRLB &= ~(TCA_SINGLE_CMP1EN_bm | TCA_SINGLE_CMP2EN_bm);
+    BUZZER_SetLow();
+    BUZZER_SetDigitalInput();
+
+    //AC1 output to LUT2 input A
+    EVSYS.CHANNEL0 = EVSYS_CHANNEL0_AC1_OUT_gc;
+    EVSYS.USERCCLLUT2A = EVSYS_USER_CHANNEL0_gc;
+
+    //LUT2 configuration is enable-protected
+    CCL.CTRLA = 0;
+    CCL.LUT2CTRLB = ALARM_LUT_CTRLB;
+    CCL.LUT2CTRLC = ALARM_LUT_CTRLC;
+    CCL.TRUTH2 = ALARM_TRUTH;
+    CCL.LUT2CTRLA = ALARM_LUT_CTRLA;
+
+    //LUT2 output on its default pin
+    PORTMUX.CCLROUTEA &= ~PORTMUX_LUT2_bm;
+    VPORTD.OUT &= ~ALARM_PIN_bm;
+    VPORTD.DIR |= ALARM_PIN_bm;
+
+    CCL.CTRLA = CCL_ENABLE_bm;
+}
+
+//Arms / disarms the hardware path, the buzzer then sounds while AC1 is tripped
+void ALARM_Arm(bool isArmed)
+{
+    //Also called by the comparator test interrupt
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _modeApply(isArmed ? (mode | ALARM_MODE_ARMED) : (mode & ~ALARM_MODE_ARMED));
+    }
+}
+
+//Forces the buzzer on / off, regardless of AC1
+void ALARM_BuzzerForce(bool isForced)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        _modeApply(isForced ? (mode | ALARM_MODE_FORCED) : (mode & ~ALARM_MODE_FORCED));
+    }
+}
+
+//Returns true if the buzzer is forced on
+bool ALARM_IsBuzzerForced(void)
+{
+    return ((mode & ALARM_MODE_FORCED) != 0);
+}
+
+//Verifies the hardware path configuration, and that the buzzer output matches AC1
+diag_result_t ALARM_Verify(void)
+{
+    //Variable corrupted
+    if (mode != (uint8_t) (~modeCheck))
+    {
+        return DIAG_FAIL;
+    }
+
+    //Routing of AC1 to LUT2, and of LUT2 to the pin
+    if ((EVSYS.CHANNEL0 != EVSYS_CHANNEL0_AC1_OUT_gc) || (EVSYS.USERCCLLUT2A != EVSYS_USER_CHANNEL0_gc))
+    {
+        return DIAG_FAIL;
+    }
+    else if (!(CCL.CTRLA & CCL_ENABLE_bm) || (CCL.LUT2CTRLA != ALARM_LUT_CTRLA) ||
+            (CCL.LUT2CTRLB != ALARM_LUT_CTRLB) || (CCL.LUT2CTRLC != ALARM_LUT_CTRLC) ||
+            (CCL.TRUTH2 != ALARM_TRUTH))
+    {
+        return DIAG_FAIL;
+    }
+    else if ((PORTMUX.CCLROUTEA & PORTMUX_LUT2_bm) || !(VPORTD.DIR & ALARM_PIN_bm))
+    {
+        return DIAG_FAIL;
+    }
+
+    //Gating of the tone
+    uint8_t tone = (mode != 0) ? toneCompare : 0;
+    uint8_t force = (mode & ALARM_MODE_FORCED) ? ALARM_FORCE_ON : ALARM_FORCE_OFF;
+    if ((TCA0.SINGLE.CMP1 != tone) || (TCA0.SINGLE.CMP2 != force))
+    {
+        return DIAG_FAIL;
+    }
+
+    //Cross-check the output against AC1, unless AC1 or the tone phase changed while sampling
+    bool isTripped = _isTripped();
+    bool isHigh;
+    bool isTonePhase;
+
+    if (!_outputSample(&isHigh, &isTonePhase) || (isTripped != _isTripped()))
+    {
+        return DIAG_PASS;
+    }
+
+    //An active output is only high in the tone phase, a stuck low output is found within a few ticks
+    bool isExpected = (mode & ALARM_MODE_FORCED) || ((mode & ALARM_MODE_ARMED) && isTripped);
+    if (isHigh != (isExpected && isTonePhase))
+    {
+        return DIAG_FAIL;
+    }
+
+    return DIAG_PASS;
+}
@@ -0,0 +1,66 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef ALARM_H
+#define	ALARM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+/* Hardware alarm path (FUSA_ENABLE_HW_ALARM in application.h)
+ * 
+ * AC1 (channel 0) -> EVSYS channel 0 -> CCL LUT2 -> buzzer
+ * 
+ * LUT2 inputs:
+ *  IN0 = EVENTA, the AC1 output
+ *  IN1 = TCA0 WO1, the buzzer tone (CMP1 = 0 when disarmed)
+ *  IN2 = TCA0 WO2, constant high when the software forces the buzzer on
+ * 
+ * OUT = WO1 AND (AC1 tripped OR WO2), on the LUT2 output pin (PD3)
+ * The buzzer must be connected to PD3, instead of PD1 (WO1)
+ */
+    
+    //Routes AC1 to the buzzer through EVSYS and the CCL, disarmed and not forced
+    void ALARM_Initialize(void);
+    
+    //Arms / disarms the hardware path, the buzzer then sounds while AC1 is tripped
+    void ALARM_Arm(bool isArmed);
+    
+    //Forces the buzzer on / off, regardless of AC1
+    void ALARM_BuzzerForce(bool isForced);
+    
+    //Returns true if the buzzer is forced on
+    bool ALARM_IsBuzzerForced(void);
+    
+    //Verifies the hardware path configuration, and that the buzzer output matches AC1
+    diag_result_t ALARM_Verify(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ALARM_H */
@@ -0,0 +1,139 @@
+#include "BOOT.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+
+//Names of the stages, for printing
+static const char* const stageNames[BOOT_STAGE_COUNT] = {
+    "Init", "CPU / WDT / SRAM", "Heater on", "Flash CRC", "EEPROM", "Comparator"
+};
+
+//RTC setup for the warm-up, restored at the end of start-up
+static uint8_t rtcControl = 0;
+static uint16_t rtcPeriod = 0;
+
+static bool isRunning = false;
+static uint16_t lastTicks = 0;
+
+//Times of each stage (boot clock ticks)
+static uint16_t stageTicks[BOOT_STAGE_COUNT];
+static uint16_t stageEndTicks[BOOT_STAGE_COUNT];
+static uint16_t totalTicks = 0;
+static uint8_t stagesRun = 0;
+
+//Waits for the RTC registers to synchronize
+static void _rtcSync(void)
+{
+    while (RTC.STATUS > 0);
+}
+
+//Starts the boot clock - call after SYSTEM_Initialize()
+void BOOT_Initialize(void)
+{
+    _rtcSync();
+    rtcControl = RTC.CTRLA;
+    rtcPeriod = RTC.PER;
+
+    RTC.CTRLA = rtcControl & ~RTC_RTCEN_bm;
+    _rtcSync();
+
+    //64 s before the counter wraps
+    RTC.PER = 0xFFFF;
+    RTC.CNT = 0;
+    _rtcSync();
+
+    RTC.CTRLA = (rtcControl & ~RTC_PRESCALER_gm) | RTC_PRESCALER_DIV32_gc | RTC_RTCEN_bm;
+
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        stageTicks[i] = 0;
+        stageEndTicks[i] = 0;
+    }
+
+    stagesRun = 0;
+    lastTicks = 0;
+    isRunning = true;
+}
+
+//Ends a stage, which started when the previous stage ended
+void BOOT_StageEnd(boot_stage_t stage)
+{
+    if (!isRunning)
+    {
+        return;
+    }
+
+    uint16_t now = RTC_ReadCounter();
+
+    stageTicks[stage] += now - lastTicks;
+    stageEndTicks[stage] = now;
+    stagesRun |= (1 << stage);
+    lastTicks = now;
+}
+
+//Stops the boot clock, and returns the RTC to counting the warm-up hours
+void BOOT_Complete(void)
+{
+    if (!isRunning)
+    {
+        return;
+    }
+
+    totalTicks = RTC_ReadCounter();
+    isRunning = false;
+
+    _rtcSync();
+    RTC.CTRLA = rtcControl & ~RTC_RTCEN_bm;
+    _rtcSync();
+
+    //Keep the time since start-up, at the warm-up rate (PER + 1 counts per hour)
+    RTC.PER = rtcPeriod;
+    RTC.CNT = (uint16_t) (((totalTicks / BOOT_CLOCK_HZ) * (rtcPeriod + 1UL)) / 3600UL);
+    _rtcSync();
+
+    //The counter passed the warm-up period and compare value during start-up
+    RTC.INTFLAGS = RTC_OVF_bm | RTC_CMP_bm;
+
+    RTC.CTRLA = rtcControl;
+}
+
+//Returns the time spent in a stage (ms)
+uint16_t BOOT_StageTimeGet(boot_stage_t stage)
+{
+    return BOOT_TICKS_TO_MS(stageTicks[stage]);
+}
+
+//Returns the time from the start of main() to the end of a stage (ms), 0 if it did not run
+uint16_t BOOT_StageEndGet(boot_stage_t stage)
+{
+    return BOOT_TICKS_TO_MS(stageEndTicks[stage]);
+}
+
+//Returns the time from the start of main() until the start-up tests completed (ms)
+uint16_t BOOT_TotalTimeGet(void)
+{
+    return BOOT_TICKS_TO_MS(totalTicks);
+}
+
+//Prints the time spent in each stage of the start-up
+void BOOT_Print(void)
+{
+    printf("Start-up profile (ms):\r\n");
+
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        //Stage did not run
+        if (!(stagesRun & (1 << i)))
+        {
+            continue;
+        }
+
+        printf("  %-16s %5u, ends at %5u\r\n", stageNames[i], BOOT_StageTimeGet(i), BOOT_StageEndGet(i));
+    }
+
+    printf("  Start-up tests complete at %u ms\r\n", BOOT_TotalTimeGet());
+}
@@ -0,0 +1,88 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BOOT_H
+#define	BOOT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+/* Start-up profiler
+ * 
+ * Interrupts are disabled during start-up, so the TIMING timebase cannot count past one
+ * wrap (39 ms) - less than the flash CRC alone. Instead, the RTC counts at 1024 Hz from
+ * the start of main() until the start-up tests are complete, then returns to counting
+ * the warm-up hours, keeping the time since start-up.
+ * 
+ * Not included: the start-up March test and WDT test before main() (including the two
+ * WDT resets of the WDT test, about 2.75 WDT periods), and SYSTEM_Initialize().
+ */
+    
+//If defined, prints the start-up profile once the self-test is complete
+//#define PRINT_BOOT_PROFILE
+    
+//Rate of the RTC during start-up (RTC clock / 32)
+#define BOOT_CLOCK_HZ 1024UL
+    
+//Converts boot clock ticks to milliseconds
+#define BOOT_TICKS_TO_MS(ticks) ((uint16_t) ((((uint32_t) (ticks)) * 1000UL) / BOOT_CLOCK_HZ))
+    
+    //Stages of the start-up, in the default order
+    typedef enum {
+        BOOT_STAGE_INIT = 0,    //Drivers, environment, trace and warm-up log
+        BOOT_STAGE_PREREQ,      //CPU, WDT and SRAM results - required for the heater
+        BOOT_STAGE_HEATER,      //Heater on
+        BOOT_STAGE_FLASH,       //Flash CRC
+        BOOT_STAGE_EEPROM,      //EEPROM checksum and calibration
+        BOOT_STAGE_AC,          //Comparator test and characterisation, at the calibrated setpoint
+        BOOT_STAGE_COUNT
+    } boot_stage_t;
+    
+    //Starts the boot clock - call after SYSTEM_Initialize()
+    void BOOT_Initialize(void);
+    
+    //Ends a stage, which started when the previous stage ended
+    void BOOT_StageEnd(boot_stage_t stage);
+    
+    //Stops the boot clock, and returns the RTC to counting the warm-up hours
+    void BOOT_Complete(void);
+    
+    //Returns the time spent in a stage (ms)
+    uint16_t BOOT_StageTimeGet(boot_stage_t stage);
+    
+    //Returns the time from the start of main() to the end of a stage (ms), 0 if it did not run
+    uint16_t BOOT_StageEndGet(boot_stage_t stage);
+    
+    //Returns the time from the start of main() until the start-up tests completed (ms)
+    uint16_t BOOT_TotalTimeGet(void);
+    
+    //Prints the time spent in each stage of the start-up
+    void BOOT_Print(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BOOT_H */
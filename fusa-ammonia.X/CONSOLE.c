@@ -0,0 +1,259 @@
+#include "CONSOLE.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "fusa.h"
+#include "SENSOR.h"
+#include "HEATER.h"
+#include "ENV.h"
+#include "WATCHDOG.h"
+#include "STACK.h"
+#include "TRACE.h"
+#include "ACTEST.h"
+#include "ACCHAR.h"
+#include "ACADC.h"
+#include "BOOT.h"
+#include "CPUCLK.h"
+
+//Line being received, owned by the ISR until lineReady is set
+static char line[CONSOLE_LINE_MAX];
+static volatile uint8_t lineLength = 0;
+static volatile bool lineReady = false;
+static volatile bool lineOverflow = false;
+
+static void (*memoryScanHandler)(void) = NULL;
+
+#ifdef CONSOLE_RESTRICTED
+//Ticks left until the commands that change the system are locked again
+static uint8_t unlockTicks = 0;
+
+//Set by the TEST press (rising edge interrupt), so a press shorter than a tick is not missed
+static volatile bool isTestPressed = false;
+
+//TEST button interrupt
+static void _testPressHandler(void)
+{
+    isTestPressed = true;
+}
+#endif
+
+//Enables the USART1 receive interrupt
+void CONSOLE_Initialize(void)
+{
+    lineLength = 0;
+    lineReady = false;
+    lineOverflow = false;
+
+#ifdef CONSOLE_RESTRICTED
+    //The TEST pin is configured for rising edge interrupts by MCC
+    T1OUT_SetInterruptHandler(&_testPressHandler);
+#endif
+
+    USART1.CTRLA |= USART_RXCIE_bm;
+}
+
+//Sets the handler for the memory scan command
+void CONSOLE_SetMemoryScanHandler(void (*handler)(void))
+{
+    memoryScanHandler = handler;
+}
+
+//Constant time per byte - no parsing or printing in the ISR
+ISR(USART1_RXC_vect)
+{
+    char c = USART1.RXDATAL;
+
+    //Previous line not run yet, drop the byte
+    if (lineReady)
+    {
+        return;
+    }
+
+    if ((c == '\r') || (c == '\n'))
+    {
+        if (lineOverflow)
+        {
+            //Too long, discard the line
+            lineOverflow = false;
+            lineLength = 0;
+        }
+        else if (lineLength != 0)
+        {
+            line[lineLength] = '\0';
+            lineReady = true;
+        }
+    }
+    else if ((c == '\b') || (c == 0x7F))
+    {
+        if (lineLength != 0)
+        {
+            lineLength--;
+        }
+    }
+    else if (lineLength < (CONSOLE_LINE_MAX - 1))
+    {
+        line[lineLength++] = c;
+    }
+    else
+    {
+        lineOverflow = true;
+    }
+}
+
+//Returns true if a command that changes the system may run
+static bool _isWriteAllowed(void)
+{
+#ifdef CONSOLE_RESTRICTED
+    //Physical presence is required in production builds
+    if (unlockTicks == 0)
+    {
+        printf("Press and release TEST to run this command\r\n");
+        return false;
+    }
+#endif
+    return true;
+}
+
+//Prints the commands
+static void _helpPrint(void)
+{
+    printf("Commands: status, scan, timing, log, ac, cal, rate <ticks>, clock <on|off>\r\n");
+}
+
+//Prints the state of the system
+static void _statusPrint(void)
+{
+    FUSA_StatusPrint();
+
+    printf("Heater: phase %u, duty = %u%%, %lu mWh\r\n",
+            HEATER_PhaseGet(), HEATER_DutyGet(), HEATER_EnergyGet());
+    printf("Environment: %d C, %u %%RH, correction = %u / 1024\r\n",
+            ENV_TemperatureGet(), ENV_HumidityGet(), ENV_CompensationGet());
+}
+
+//Prints the execution time of the diagnostics
+static void _timingPrint(void)
+{
+    SENSOR_ChannelStatsPrint();
+    FUSA_SRAMCoveragePrint();
+    WATCHDOG_HistogramPrint();
+    STACK_UsagePrint();
+    ACTEST_StatsPrint();
+    BOOT_Print();
+    CPUCLK_StatsPrint();
+#ifdef FUSA_ENABLE_AC_ADC
+    ACADC_StatsPrint();
+#endif
+}
+
+//Runs a command line
+static void _commandRun(char* cmd)
+{
+    char* arg = strchr(cmd, ' ');
+    if (arg != NULL)
+    {
+        *arg++ = '\0';
+    }
+
+    if (strcmp(cmd, "status") == 0)
+    {
+        _statusPrint();
+    }
+    else if (strcmp(cmd, "scan") == 0)
+    {
+        if (memoryScanHandler != NULL)
+        {
+            memoryScanHandler();
+            printf("Memory scan requested\r\n");
+        }
+    }
+    else if (strcmp(cmd, "timing") == 0)
+    {
+        _timingPrint();
+    }
+    else if (strcmp(cmd, "log") == 0)
+    {
+        TRACE_Print();
+    }
+    else if (strcmp(cmd, "ac") == 0)
+    {
+        ACCHAR_TrendPrint();
+        ACTEST_StatsPrint();
+    }
+    else if (strcmp(cmd, "cal") == 0)
+    {
+        if (_isWriteAllowed() && !FUSA_CalibrationRequest())
+        {
+            printf("Calibration is only available while monitoring\r\n");
+        }
+    }
+    else if (strcmp(cmd, "rate") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Telemetry every %u ticks\r\n", FUSA_TelemetryRateGet());
+        }
+        else if (_isWriteAllowed())
+        {
+            //0 disables the telemetry
+            FUSA_TelemetryRateSet((uint16_t) strtoul(arg, NULL, 10));
+            printf("Telemetry every %u ticks\r\n", FUSA_TelemetryRateGet());
+        }
+    }
+    else if (strcmp(cmd, "clock") == 0)
+    {
+        //Compare the section times and the charge per tick with and without the boost
+        if ((arg == NULL) || ((strcmp(arg, "on") != 0) && (strcmp(arg, "off") != 0)))
+        {
+            CPUCLK_StatsPrint();
+        }
+        else if (_isWriteAllowed())
+        {
+            CPUCLK_BoostEnable(strcmp(arg, "on") == 0);
+            printf("Clock boost %s, statistics cleared\r\n", arg);
+        }
+    }
+    else
+    {
+        _helpPrint();
+    }
+}
+
+//Called once per tick, runs a received command
+void CONSOLE_Service(void)
+{
+#ifdef CONSOLE_RESTRICTED
+    //Open the unlock window once a latched TEST press has been released
+    if (isTestPressed && !TEST_BUTTON_GetValue())
+    {
+        isTestPressed = false;
+        unlockTicks = CONSOLE_UNLOCK_TICKS;
+        printf("Commands unlocked for %u s\r\n", CONSOLE_UNLOCK_TICKS / 2);
+    }
+    else if (unlockTicks != 0)
+    {
+        unlockTicks--;
+    }
+#endif
+
+    if (!lineReady)
+    {
+        return;
+    }
+
+    //Format the output at the boosted clock
+    CPUCLK_Boost(CPUCLK_PRINT);
+    _commandRun(line);
+    CPUCLK_Release(CPUCLK_PRINT);
+
+    //Hand the buffer back to the ISR
+    lineLength = 0;
+    lineReady = false;
+}
@@ -0,0 +1,57 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef CONSOLE_H
+#define	CONSOLE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Longest command line, including the terminator
+#define CONSOLE_LINE_MAX 24
+    
+//In production builds, commands that change the system are only accepted after the TEST button is pressed and released
+//TEST held in the Monitor state runs the alarm test, so presence is checked on the release
+#ifndef DEVELOP_MODE
+#define CONSOLE_RESTRICTED
+#endif
+    
+//Number of 0.5s ticks the commands stay unlocked after TEST is released (30s)
+#define CONSOLE_UNLOCK_TICKS 60
+    
+    //Enables the USART1 receive interrupt
+    void CONSOLE_Initialize(void);
+    
+    //Sets the handler for the memory scan command
+    void CONSOLE_SetMemoryScanHandler(void (*handler)(void));
+    
+    //Called once per tick, runs a received command
+    void CONSOLE_Service(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CONSOLE_H */
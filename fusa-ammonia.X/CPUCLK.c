@@ -0,0 +1,264 @@
+#include "CPUCLK.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "mcc_generated_files/timer/delay.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+#include "application.h"
+#include "TIMING.h"
+#include "PATTERN.h"
+#include "ACTEST.h"
+
+//diag_config.h was regenerated by MCC, the start-up March test would run at the reset clock
+#if !DIAG_SRAM_MARCH_ALT_CLK_FRQ_ENABLED
+#error "MCC regenerated diag_config.h: set DIAG_SRAM_MARCH_ALT_CLK_FRQ_ENABLED to (1U) again, see CPUCLK.h"
+#endif
+
+//Names of the sections, for printing
+static const char* const userNames[CPUCLK_USER_COUNT] = {
+    "Flash CRC", "SRAM March", "Print"
+};
+
+static uint8_t scale = 1;
+static uint8_t depth = 0;
+static bool isBoostEnabled = true;
+static uint16_t baudBase = 0;
+
+//Boosts and boosts refused (buzzer / comparator test)
+static uint16_t boostCount = 0;
+static uint16_t boostSkipCount = 0;
+
+//Section times (TIMING ticks), the mean is over the last window
+static uint32_t sectionStart[CPUCLK_USER_COUNT];
+static uint32_t sectionSum[CPUCLK_USER_COUNT];
+static uint16_t sectionCount[CPUCLK_USER_COUNT];
+static uint32_t sectionMean[CPUCLK_USER_COUNT];
+static uint32_t sectionMax[CPUCLK_USER_COUNT];
+
+//Boosted time in the current tick (TIMING ticks)
+static uint32_t boostStart = 0;
+static uint32_t tickBoostTicks = 0;
+
+//Averages per tick over the last window (us, nC)
+static uint32_t windowBusyUs = 0;
+static uint32_t windowBoostUs = 0;
+static uint8_t windowTicks = 0;
+static uint32_t busyUs = 0;
+static uint32_t boostUs = 0;
+static uint32_t chargeNC = 0;
+
+//Waits for the last character to leave, the baud rate changes with CLK_PER
+static void _uartDrain(void)
+{
+    if (!(USART1.CTRLB & USART_TXEN_bm))
+    {
+        return;
+    }
+
+    while (!(USART1.STATUS & USART_DREIF_bm));
+
+    //TXCIF is cleared at each change, it is only set if a character was sent since
+    uint32_t start = TIMING_TimestampGet();
+    while (!(USART1.STATUS & USART_TXCIF_bm) &&
+            (TIMING_ElapsedGet(start) < TIMING_US_TO_TICKS(CPUCLK_UART_FRAME_US)));
+
+    USART1.STATUS = USART_TXCIF_bm;
+}
+
+//Changes CLK_PER, and the peripherals that depend on it
+static void _scaleSet(uint8_t newScale)
+{
+    if (newScale == scale)
+    {
+        return;
+    }
+
+    _uartDrain();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        //Rebase the timebase at the old rate
+        TIMING_ScaleSet(newScale);
+
+        ccp_write_io((void*) &(CLKCTRL.MCLKCTRLB), (newScale == 1) ? CPUCLK_BASE_PDIV : CPUCLK_BOOST_PDIV);
+
+        PATTERN_ScaleSet(newScale);
+        USART1.BAUD = baudBase * newScale;
+
+        scale = newScale;
+    }
+}
+
+//Clears the statistics
+static void _statsClear(void)
+{
+    for (uint8_t i = 0; i < CPUCLK_USER_COUNT; i++)
+    {
+        sectionSum[i] = 0;
+        sectionCount[i] = 0;
+        sectionMean[i] = 0;
+        sectionMax[i] = 0;
+    }
+
+    boostCount = 0;
+    boostSkipCount = 0;
+    tickBoostTicks = 0;
+    windowBusyUs = 0;
+    windowBoostUs = 0;
+    windowTicks = 0;
+    busyUs = 0;
+    boostUs = 0;
+    chargeNC = 0;
+}
+
+//Saves the USART1 baud rate at F_CPU - call after SYSTEM_Initialize() and TIMING_Initialize()
+void CPUCLK_Initialize(void)
+{
+    baudBase = USART1.BAUD;
+    scale = 1;
+    depth = 0;
+
+    _statsClear();
+}
+
+//Boosts CLK_PER for a section, sections can be nested (main loop only)
+void CPUCLK_Boost(cpuclk_user_t user)
+{
+    sectionStart[user] = TIMING_TimestampGet();
+
+    if (depth++ > 0)
+    {
+        return;
+    }
+
+    if (!isBoostEnabled)
+    {
+        return;
+    }
+
+    //The alarm tone comes from TCA0, and a running comparator test is timed by TCB3
+    //At start-up (interrupts disabled) only the self-test beep changes pitch
+    if ((BUZZER_IS_ENABLED() && (SREG & CPU_I_bm)) || ACTEST_IsRunning())
+    {
+        boostSkipCount++;
+        return;
+    }
+
+    _scaleSet(CPUCLK_BOOST_SCALE);
+
+    boostStart = TIMING_TimestampGet();
+    boostCount++;
+}
+
+//Ends a section, CLK_PER returns to F_CPU when the outermost section ends
+void CPUCLK_Release(cpuclk_user_t user)
+{
+    uint32_t now = TIMING_TimestampGet();
+
+    //Interrupts are disabled at start-up, and the timebase cannot count a long section
+    if (SREG & CPU_I_bm)
+    {
+        uint32_t ticks = now - sectionStart[user];
+
+        sectionSum[user] += ticks;
+        sectionCount[user]++;
+
+        if (ticks > sectionMax[user])
+        {
+            sectionMax[user] = ticks;
+        }
+    }
+
+    if ((depth == 0) || (--depth > 0))
+    {
+        return;
+    }
+
+    if (scale != 1)
+    {
+        tickBoostTicks += now - boostStart;
+        _scaleSet(1);
+    }
+}
+
+//Returns CLK_PER / F_CPU
+uint8_t CPUCLK_ScaleGet(void)
+{
+    return scale;
+}
+
+//Waits for a time at any CLK_PER (us)
+void CPUCLK_DelayMicroseconds(uint16_t us)
+{
+    //DELAY_microseconds() counts cycles at F_CPU
+    for (uint8_t i = 0; i < scale; i++)
+    {
+        DELAY_microseconds(us);
+    }
+}
+
+//Allows or stops boosting, and clears the statistics for a comparison
+void CPUCLK_BoostEnable(bool isEnabled)
+{
+    isBoostEnabled = isEnabled;
+    _statsClear();
+}
+
+//Records the time the main loop was busy in a tick (TIMING ticks)
+void CPUCLK_TickRecord(uint32_t busyTicks)
+{
+    windowBusyUs += TIMING_TICKS_TO_US(busyTicks);
+    windowBoostUs += TIMING_TICKS_TO_US(tickBoostTicks);
+    tickBoostTicks = 0;
+
+    windowTicks++;
+    if (windowTicks < CPUCLK_WINDOW_TICKS)
+    {
+        return;
+    }
+
+    busyUs = windowBusyUs / windowTicks;
+    boostUs = windowBoostUs / windowTicks;
+
+    if (boostUs > busyUs)
+    {
+        boostUs = busyUs;
+    }
+
+    uint32_t idleUs = (busyUs < CPUCLK_TICK_US) ? (CPUCLK_TICK_US - busyUs) : 0;
+
+    //uA * us = pC
+    chargeNC = (((busyUs - boostUs) * CPUCLK_ACTIVE_UA) + (boostUs * CPUCLK_BOOST_UA) +
+            (idleUs * CPUCLK_IDLE_UA)) / 1000UL;
+
+    for (uint8_t i = 0; i < CPUCLK_USER_COUNT; i++)
+    {
+        sectionMean[i] = (sectionCount[i] == 0) ? 0 : (sectionSum[i] / sectionCount[i]);
+        sectionSum[i] = 0;
+        sectionCount[i] = 0;
+    }
+
+    windowBusyUs = 0;
+    windowBoostUs = 0;
+    windowTicks = 0;
+}
+
+//Prints the section times and the estimated charge per tick
+void CPUCLK_StatsPrint(void)
+{
+    printf("Clock: boost %s (x%u), %u boosts, %u refused\r\n",
+            isBoostEnabled ? "on" : "off", CPUCLK_BOOST_SCALE, boostCount, boostSkipCount);
+
+    for (uint8_t i = 0; i < CPUCLK_USER_COUNT; i++)
+    {
+        printf("  %-10s mean = %lu us, worst = %lu us\r\n", userNames[i],
+                TIMING_TICKS_TO_US(sectionMean[i]), TIMING_TICKS_TO_US(sectionMax[i]));
+    }
+
+    printf("  Per tick: busy = %lu us (boosted %lu us), charge = %lu nC\r\n", busyUs, boostUs, chargeNC);
+}
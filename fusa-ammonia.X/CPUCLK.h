@@ -0,0 +1,117 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef CPUCLK_H
+#define	CPUCLK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include <avr/io.h>
+    
+/* CPU clock scaling
+ * 
+ * CLK_PER normally runs at F_CPU (OSCHF / 6). The heavy diagnostics - the flash CRC,
+ * the SRAM March sections and the printed reports - run at OSCHF / 2, then the clock
+ * drops back, and the main loop sleeps for the rest of the tick.
+ * 
+ * When CLK_PER changes:
+ * - The TIMING timebase keeps counting in 0.6 us ticks, so all measurements stay valid
+ * - The PATTERN step tick keeps its CCMP period, and USART1 keeps its baud rate,
+ *   after the last character has been sent
+ * - DELAY_microseconds() is calibrated for F_CPU, use CPUCLK_DelayMicroseconds()
+ * - TCB3 (ACTEST) and TCB0 (ACCHAR) scale their tick conversions by CPUCLK_ScaleGet()
+ * - TCA0 runs faster - the heater PWM keeps its duty cycle, the buzzer tone would not,
+ *   so the clock is not boosted while the buzzer sounds (except the start-up beep)
+ * - The clock is not boosted while a split-phase comparator test is waiting on TCB3
+ * - CLK_ADC runs faster (104 kHz to 312 kHz), no conversions are made while boosted
+ * 
+ * OSCHF / 2 = 10 MHz is within the speed grade of the device above the BOD level.
+ * The start-up March test (before main) uses the same divider, see
+ * DIAG_SRAM_MARCH_ALT_CLK_FRQ in diag_config.h. DIAG_SRAM_MARCH_ALT_CLK_FRQ_ENABLED
+ * is set to 1U by hand after generation, the MCC configuration (.mc3) leaves it at 0U.
+ * CPUCLK.c stops the build with #error if a regeneration sets it back to 0U.
+ */
+    
+//CLK_PER dividers, normal (F_CPU) and boosted
+#define CPUCLK_BASE_PDIV (CLKCTRL_PDIV_DIV6_gc | CLKCTRL_PEN_bm)
+#define CPUCLK_BOOST_PDIV (CLKCTRL_PDIV_DIV2_gc | CLKCTRL_PEN_bm)
+    
+//Boosted CLK_PER / F_CPU
+#define CPUCLK_BOOST_SCALE 3
+    
+//Longest time for the last UART character to leave before the baud rate changes (us)
+#define CPUCLK_UART_FRAME_US 100
+    
+//Typical supply current in each mode (uA), for the estimated charge per tick
+//Measure the board for accurate numbers
+#define CPUCLK_ACTIVE_UA 900
+#define CPUCLK_BOOST_UA 2200
+#define CPUCLK_IDLE_UA 450
+    
+//Length of a tick (us), and the number of ticks averaged
+#define CPUCLK_TICK_US 500000UL
+#define CPUCLK_WINDOW_TICKS 64
+    
+//If defined, prints the clock statistics every hour
+//#define PRINT_CLOCK_STATS
+    
+    //Sections run at the boosted clock
+    typedef enum {
+        CPUCLK_FLASH = 0,       //Flash CRC (start-up, hourly scan and segments)
+        CPUCLK_SRAM,            //SRAM March C- sections
+        CPUCLK_PRINT,           //Reports and console output
+        CPUCLK_USER_COUNT
+    } cpuclk_user_t;
+    
+    //Saves the USART1 baud rate at F_CPU - call after SYSTEM_Initialize() and TIMING_Initialize()
+    void CPUCLK_Initialize(void);
+    
+    //Boosts CLK_PER for a section, sections can be nested (main loop only)
+    void CPUCLK_Boost(cpuclk_user_t user);
+    
+    //Ends a section, CLK_PER returns to F_CPU when the outermost section ends
+    void CPUCLK_Release(cpuclk_user_t user);
+    
+    //Returns CLK_PER / F_CPU
+    uint8_t CPUCLK_ScaleGet(void);
+    
+    //Waits for a time at any CLK_PER (us)
+    void CPUCLK_DelayMicroseconds(uint16_t us);
+    
+    //Allows or stops boosting, and clears the statistics for a comparison
+    void CPUCLK_BoostEnable(bool isEnabled);
+    
+    //Records the time the main loop was busy in a tick (TIMING ticks)
+    void CPUCLK_TickRecord(uint32_t busyTicks);
+    
+    //Prints the section times and the estimated charge per tick
+    void CPUCLK_StatsPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CPUCLK_H */
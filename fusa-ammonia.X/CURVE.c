@@ -0,0 +1,354 @@
+#include "CURVE.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+#include "EEPROM.h"
+#include "SENSOR.h"
+
+#if (CURVE_SEGMENTS_MAX > EEPROM_CURVE_SEGMENTS_MAX)
+#error CURVE_SEGMENTS_MAX exceeds the segments reserved in the EEPROM map
+#endif
+
+#if (EEPROM_CURVE_ADDR(EEPROM_MAX_CHANNELS) > (DIAG_EEPROM_START_ADDR + DIAG_EEPROM_LENGTH))
+#error The gas curves do not fit in the CRC protected region of the EEPROM
+#endif
+
+#if (CURVE_CAL_POINTS > CURVE_POINTS_MAX)
+#error CURVE_CAL_POINTS exceeds CURVE_POINTS_MAX
+#endif
+
+//Concentrations of the lookup table points (ppm)
+static const uint16_t tablePPM[CURVE_TABLE_POINTS] = {
+    1, 2, 3, 4, 5, 7, 10, 15, 20, 25, 30, 40,
+    50, 60, 75, 100, 125, 150, 200, 250, 300, 400, 500, 1000
+};
+
+//Ratio (Q12) at each point of the lookup table, decreasing
+static uint16_t ratioTable[SENSOR_CHANNEL_COUNT][CURVE_TABLE_POINTS];
+
+//Slope (Q10) of the curve at the last point of the table, to extrapolate above it
+static int16_t lastSlope[SENSOR_CHANNEL_COUNT];
+static bool isCalibrated[SENSOR_CHANNEL_COUNT];
+
+//Captured calibration points, sorted by PPM
+static uint16_t capturePPM[CURVE_POINTS_MAX];
+static uint16_t captureRatio[CURVE_POINTS_MAX][SENSOR_CHANNEL_COUNT];
+static uint8_t captureCount = 0;
+
+//Fitted curve of every channel, waiting to be written
+static curve_segment_t fitSegments[SENSOR_CHANNEL_COUNT][CURVE_SEGMENTS_MAX];
+static uint8_t fitCount = 0;
+
+//Reads and validates the curve of a channel, returns the number of segments (0 if not valid)
+static uint8_t _curveRead(uint8_t channel, curve_segment_t* segments)
+{
+    uint16_t addr = EEPROM_CURVE_ADDR(channel);
+    uint8_t count = EEPROM_ByteRead(addr);
+
+    //No curve stored
+    if (count == 0xFF)
+    {
+        return 0;
+    }
+
+    if ((count == 0) || (count > CURVE_SEGMENTS_MAX))
+    {
+        printf("CH%u: Invalid gas curve, using default.\r\n", channel);
+        return 0;
+    }
+
+    addr++;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        segments[i].ratio = EEPROM_WordRead(addr);
+        segments[i].ppm = EEPROM_WordRead(addr + 2);
+        segments[i].slope = (int16_t) EEPROM_WordRead(addr + 4);
+        addr += 6;
+
+        //Ratio must fall and PPM must rise along the curve
+        bool isValid = (segments[i].ratio != 0) && (segments[i].ppm != 0) && (segments[i].slope < 0);
+        if ((i > 0) && ((segments[i].ratio >= segments[i - 1].ratio) || (segments[i].ppm <= segments[i - 1].ppm)))
+        {
+            isValid = false;
+        }
+
+        if (!isValid)
+        {
+            printf("CH%u: Invalid gas curve, using default.\r\n", channel);
+            return 0;
+        }
+    }
+
+    return count;
+}
+
+//Returns the segment containing a concentration, the first / last segments extrapolate
+static uint8_t _segmentFind(const curve_segment_t* segments, uint8_t count, uint16_t ppm)
+{
+    uint8_t i = 0;
+    while (((i + 1) < count) && (ppm >= segments[i + 1].ppm))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+//Computes the ratio (Q12) at a concentration from the curve segments
+static uint16_t _ratioCompute(const curve_segment_t* segments, uint8_t count, uint16_t ppm)
+{
+    uint8_t i = _segmentFind(segments, count, ppm);
+
+    //R = ratio * (PPM / ppm)^(1 / slope)
+    float ratio = segments[i].ratio * powf(((float) ppm) / segments[i].ppm, ((float) CURVE_SLOPE_ONE) / segments[i].slope);
+
+    if (ratio >= UINT16_MAX)
+    {
+        return UINT16_MAX;
+    }
+    else if (ratio < 1)
+    {
+        return 1;
+    }
+
+    return (uint16_t) lroundf(ratio);
+}
+
+//Loads the curve of a channel from EEPROM and builds the lookup table
+void CURVE_Load(uint8_t channel)
+{
+    curve_segment_t segments[CURVE_SEGMENTS_MAX];
+    uint8_t count = _curveRead(channel, segments);
+
+    isCalibrated[channel] = (count != 0);
+
+    if (count == 0)
+    {
+        //Datasheet curve
+        segments[0].ratio = CURVE_DEFAULT_RATIO;
+        segments[0].ppm = CURVE_DEFAULT_PPM;
+        segments[0].slope = CURVE_DEFAULT_SLOPE;
+        count = 1;
+    }
+
+    for (uint8_t k = 0; k < CURVE_TABLE_POINTS; k++)
+    {
+        ratioTable[channel][k] = _ratioCompute(segments, count, tablePPM[k]);
+
+#ifdef PRINT_CURVE_DATA
+        printf("CH%u: %u ppm at R_S / R_0 = %u / 4096\r\n", channel, tablePPM[k], ratioTable[channel][k]);
+#endif
+    }
+
+    lastSlope[channel] = segments[_segmentFind(segments, count, tablePPM[CURVE_TABLE_POINTS - 1])].slope;
+}
+
+//Returns true if the channel uses a multi-point calibrated curve
+bool CURVE_IsCalibrated(uint8_t channel)
+{
+    return isCalibrated[channel];
+}
+
+//Returns the ratio (R_S / R_0) of a channel at a concentration in the lookup table (Q12)
+uint16_t CURVE_RatioGet(uint8_t channel, uint16_t ppm)
+{
+    const uint16_t* table = ratioTable[channel];
+
+    if (ppm <= tablePPM[0])
+    {
+        return table[0];
+    }
+
+    uint8_t k = 0;
+    while (((k + 2) < CURVE_TABLE_POINTS) && (ppm > tablePPM[k + 1]))
+    {
+        k++;
+    }
+
+    if (ppm >= tablePPM[k + 1])
+    {
+        return table[k + 1];
+    }
+
+    //Linear interpolation between table points
+    uint32_t delta = ((uint32_t) (table[k] - table[k + 1])) * (ppm - tablePPM[k]);
+    return table[k] - (uint16_t) (delta / (tablePPM[k + 1] - tablePPM[k]));
+}
+
+//Converts a ratio (R_S / R_0, Q12) to PPM using the lookup table, extrapolated above the table (up to UINT16_MAX)
+uint16_t CURVE_PPMGet(uint8_t channel, uint16_t ratio)
+{
+    const uint16_t* table = ratioTable[channel];
+
+    //Below the first point of the table
+    if (ratio > table[0])
+    {
+        return 0;
+    }
+
+    //Above the last point of the table, extrapolate along the curve (not limited to the table)
+    if (ratio <= table[CURVE_TABLE_POINTS - 1])
+    {
+        //PPM = ppm * (R / ratio)^slope
+        float ppm = tablePPM[CURVE_TABLE_POINTS - 1] *
+                powf(((float) ratio) / table[CURVE_TABLE_POINTS - 1], ((float) lastSlope[channel]) / CURVE_SLOPE_ONE);
+
+        return (ppm >= UINT16_MAX) ? UINT16_MAX : (uint16_t) lroundf(ppm);
+    }
+
+    //Find table[k] >= ratio > table[k + 1]
+    uint8_t k = 0;
+    while (ratio <= table[k + 1])
+    {
+        k++;
+    }
+
+    //Linear interpolation between table points
+    uint16_t span = table[k] - table[k + 1];
+    uint32_t delta = ((uint32_t) (tablePPM[k + 1] - tablePPM[k])) * (table[k] - ratio);
+    return tablePPM[k] + (uint16_t) ((delta + (span / 2)) / span);
+}
+
+//Clears the captured calibration points
+void CURVE_CaptureStart(void)
+{
+    captureCount = 0;
+}
+
+//Adds a calibration point, with the ratio (Q12) of every channel
+bool CURVE_PointCapture(uint16_t ppm, const uint16_t* ratios)
+{
+    if ((ppm == 0) || (captureCount >= CURVE_POINTS_MAX))
+    {
+        return false;
+    }
+
+    //Find the sorted position of the point
+    uint8_t index = 0;
+    while ((index < captureCount) && (capturePPM[index] < ppm))
+    {
+        index++;
+    }
+
+    //Each concentration can only be captured once
+    if ((index < captureCount) && (capturePPM[index] == ppm))
+    {
+        return false;
+    }
+
+    //Make room for the new point
+    for (uint8_t i = captureCount; i > index; i--)
+    {
+        capturePPM[i] = capturePPM[i - 1];
+        for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        {
+            captureRatio[i][ch] = captureRatio[i - 1][ch];
+        }
+    }
+
+    capturePPM[index] = ppm;
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        captureRatio[index][ch] = ratios[ch];
+    }
+
+    captureCount++;
+
+    return true;
+}
+
+//Fits the captured points of every channel
+bool CURVE_Fit(void)
+{
+    //At least 2 points are needed for a segment
+    if (captureCount < 2)
+    {
+        printf("Not enough calibration points.\r\n");
+        return false;
+    }
+
+    fitCount = 0;
+
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        for (uint8_t i = 0; i < (captureCount - 1); i++)
+        {
+            uint16_t r0 = captureRatio[i][ch];
+            uint16_t r1 = captureRatio[i + 1][ch];
+
+            //Sensor resistance must fall as the concentration rises
+            if ((r1 == 0) || (r1 >= r0))
+            {
+                printf("CH%u: Sensor response is not monotonic at %u ppm.\r\n", ch, capturePPM[i + 1]);
+                return false;
+            }
+
+            //Slope in log-log space
+            float slope = logf(((float) capturePPM[i + 1]) / capturePPM[i]) / logf(((float) r1) / r0);
+            slope *= CURVE_SLOPE_ONE;
+
+            //Must fit in Q10, and be negative after rounding
+            if ((slope <= INT16_MIN) || (slope > -0.5))
+            {
+                printf("CH%u: Sensor response is out of range at %u ppm.\r\n", ch, capturePPM[i + 1]);
+                return false;
+            }
+
+            fitSegments[ch][i].ratio = r0;
+            fitSegments[ch][i].ppm = capturePPM[i];
+            fitSegments[ch][i].slope = (int16_t) lroundf(slope);
+        }
+    }
+
+    fitCount = captureCount - 1;
+
+    return true;
+}
+
+//Writes the fitted curve of every channel to EEPROM
+bool CURVE_Write(void)
+{
+    if (fitCount == 0)
+    {
+        return false;
+    }
+
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        uint16_t addr = EEPROM_CURVE_ADDR(ch);
+
+        //Invalidate the record until all segments are written
+        if (!EEPROM_ByteWrite(addr, 0xFF))
+            return false;
+
+        for (uint8_t i = 0; i < fitCount; i++)
+        {
+            uint16_t segAddr = addr + 1 + (6 * i);
+
+            if (!EEPROM_WordWrite(segAddr, fitSegments[ch][i].ratio))
+                return false;
+
+            if (!EEPROM_WordWrite(segAddr + 2, fitSegments[ch][i].ppm))
+                return false;
+
+            if (!EEPROM_WordWrite(segAddr + 4, (uint16_t) fitSegments[ch][i].slope))
+                return false;
+        }
+
+        if (!EEPROM_ByteWrite(addr, fitCount))
+            return false;
+    }
+
+    return true;
+}
+
+//Erases the stored curve of a channel
+bool CURVE_Erase(uint8_t channel)
+{
+    return EEPROM_ByteWrite(EEPROM_CURVE_ADDR(channel), 0xFF);
+}
@@ -0,0 +1,96 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef CURVE_H
+#define	CURVE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Prints the gas response curve of each channel when loaded
+//#define PRINT_CURVE_DATA
+    
+//Max number of reference gas points in a multi-point calibration
+#define CURVE_POINTS_MAX 6
+#define CURVE_SEGMENTS_MAX (CURVE_POINTS_MAX - 1)
+    
+//Reference gas concentrations (ppm) applied, in order, during a button driven calibration
+#define CURVE_CAL_POINTS 4
+#define CURVE_CAL_PPM {10, 25, 50, 100}
+    
+//Ratios (R_S / R_0) are Q12, slopes (d ln(PPM) / d ln(ratio)) are Q10
+#define CURVE_RATIO_ONE 4096
+#define CURVE_SLOPE_ONE 1024
+    
+//Default curve, from a best-fit plot of the MQ-137 datasheet
+//PPM = 0.1282 * ratio^(-3.833), anchored at 50 ppm
+#define CURVE_DEFAULT_RATIO 864
+#define CURVE_DEFAULT_PPM 50
+#define CURVE_DEFAULT_SLOPE (-3925)
+    
+//Number of points in the runtime lookup table
+#define CURVE_TABLE_POINTS 24
+    
+    //One segment of a piecewise log-log curve
+    //PPM = ppm * (R / ratio)^slope
+    typedef struct {
+        uint16_t ratio;     //Ratio at the start of the segment (Q12)
+        uint16_t ppm;       //PPM at the start of the segment
+        int16_t slope;      //Log-log slope of the segment (Q10)
+    } curve_segment_t;
+    
+    //Loads the curve of a channel from EEPROM and builds the lookup table
+    void CURVE_Load(uint8_t channel);
+    
+    //Returns true if the channel uses a multi-point calibrated curve
+    bool CURVE_IsCalibrated(uint8_t channel);
+    
+    //Returns the ratio (R_S / R_0) of a channel at a concentration in the lookup table (Q12)
+    uint16_t CURVE_RatioGet(uint8_t channel, uint16_t ppm);
+    
+    //Converts a ratio (R_S / R_0, Q12) to PPM using the lookup table, extrapolated above the table (up to UINT16_MAX)
+    uint16_t CURVE_PPMGet(uint8_t channel, uint16_t ratio);
+    
+    //Clears the captured calibration points
+    void CURVE_CaptureStart(void);
+    
+    //Adds a calibration point, with the ratio (Q12) of every channel
+    bool CURVE_PointCapture(uint16_t ppm, const uint16_t* ratios);
+    
+    //Fits the captured points of every channel
+    bool CURVE_Fit(void);
+    
+    //Writes the fitted curve of every channel to EEPROM
+    //The EEPROM checksum must be updated by the caller
+    bool CURVE_Write(void);
+    
+    //Erases the stored curve of a channel
+    bool CURVE_Erase(uint8_t channel);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CURVE_H */
@@ -7,18 +7,14 @@
 
 #include "mcc_generated_files/system/system.h"
 #include "application.h"
+#include "TIMING.h"
 
-//Writes and verifies a byte to the EEPROM. Returns true if successful
-bool EEPROM_ByteWrite(uint16_t address, uint8_t data)
+//Blocks new writes once the supply is failing
+static volatile bool isWriteLocked = false;
+
+//Writes and verifies a byte, without checking the supply
+static bool _byteWrite(uint16_t address, uint8_t data)
 {
-    //Check to see if VDD is OK
-    //If VLM is 1, then we are below threshold
-    if (!APP_VLMStatusGet())
-    {
-        printf("BOD ERROR\r\n");
-        return false;
-    }
-    
     //Address is out of bounds
     if (address > EEPROM_END)
     {
@@ -55,6 +51,37 @@ bool EEPROM_ByteWrite(uint16_t address, uint8_t data)
     return true;
 }
 
+//Writes and verifies a byte to the EEPROM. Returns true if successful
+bool EEPROM_ByteWrite(uint16_t address, uint8_t data)
+{
+    //Check to see if VDD is OK
+    //If VLM is 1, then we are below threshold
+    if (isWriteLocked || !APP_VLMStatusGet())
+    {
+        printf("BOD ERROR\r\n");
+        return false;
+    }
+    
+    return _byteWrite(address, data);
+}
+
+//Writes and verifies a byte while the supply is failing (power-fail flush only)
+bool EEPROM_EmergencyByteWrite(uint16_t address, uint8_t data)
+{
+    bool isWritten = _byteWrite(address, data);
+    
+    //Interrupts are disabled, keep the timebase counting across the write
+    TIMING_TimestampGet();
+    
+    return isWritten;
+}
+
+//Stops any new writes, except EEPROM_EmergencyByteWrite
+void EEPROM_WriteLock(void)
+{
+    isWriteLocked = true;
+}
+
 //Writes and verifies a 16-bit word to the EEPROM. Returns true if successful
 bool EEPROM_WordWrite(uint16_t address, uint16_t data)
 {
@@ -102,7 +129,17 @@ uint16_t EEPROM_ChecksumCalculate(void)
     //Sum the bytes as 16-bit words
     for (uint16_t index = 0; index < EEPROM_SIZE; index++)
     {
-        addWord |= EEPROM_ByteRead(index);
+        uint16_t addr = EEPROM_START + index;
+        
+        //The warm-up log changes at run-time, count it as erased
+        if ((addr >= EEPROM_WARMUP_LOG_ADDR) && (addr < (EEPROM_WARMUP_LOG_ADDR + EEPROM_WARMUP_LOG_SIZE)))
+        {
+            addWord |= 0xFF;
+        }
+        else
+        {
+            addWord |= EEPROM_ByteRead(addr);
+        }
         
         if (isLoaded)
         {
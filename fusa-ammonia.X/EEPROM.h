@@ -33,7 +33,7 @@ extern "C" {
 
 //8-bit unsigned integer that indicates the version of the EEPROM mapping
 //Used to detect mismatches during development / firmware upgrades
-#define EEPROM_VERSION_ID 1
+#define EEPROM_VERSION_ID 2
 
 //Address of the EEPROM Version
 #define EEPROM_VERSION_ADDR (0 + EEPROM_START)
@@ -41,16 +41,51 @@ extern "C" {
 //Address of the Zero-Point / Reference Value
 #define EEPROM_REF_VALUE_H_ADDR (EEPROM_VERSION_ADDR + 1)
 #define EEPROM_REF_VALUE_L_ADDR (EEPROM_REF_VALUE_H_ADDR + 1)
+    
+//Maximum number of sensor channels with space reserved in the EEPROM map
+#define EEPROM_MAX_CHANNELS 4
+    
+//Address of the Zero-Point / Reference Value of a sensor channel
+#define EEPROM_REF_VALUE_ADDR(channel) (EEPROM_REF_VALUE_H_ADDR + (2 * (channel)))
+    
+//Address of the tracked (drift compensated) baseline of a sensor channel
+//0xFFFF if no baseline has been stored since calibration
+#define EEPROM_BASELINE_ADDR(channel) (EEPROM_REF_VALUE_ADDR(EEPROM_MAX_CHANNELS) + (2 * (channel)))
+    
+//Address of the temperature / humidity correction at calibration (Q10)
+//0xFFFF if the environment was not measured at calibration
+#define EEPROM_ENV_CAL_ADDR (EEPROM_BASELINE_ADDR(EEPROM_MAX_CHANNELS))
+    
+//Max number of segments in the gas response curve of a sensor channel
+#define EEPROM_CURVE_SEGMENTS_MAX 5
+    
+//Size of a gas response curve: segment count, then ratio, ppm and slope words per segment
+#define EEPROM_CURVE_SIZE (1 + (6 * EEPROM_CURVE_SEGMENTS_MAX))
+    
+//Address of the gas response curve of a sensor channel
+//Segment count is 0xFF if the channel uses the default curve
+#define EEPROM_CURVE_ADDR(channel) (EEPROM_ENV_CAL_ADDR + 2 + (EEPROM_CURVE_SIZE * (channel)))
 
 //Address of the Checksum for the EEPROM
-#define EEPROM_CKSM_H_ADDR (EEPROM_SIZE - 2)
-#define EEPROM_CKSM_L_ADDR (EEPROM_SIZE - 1)
+#define EEPROM_CKSM_H_ADDR (EEPROM_START + EEPROM_SIZE - 2)
+#define EEPROM_CKSM_L_ADDR (EEPROM_START + EEPROM_SIZE - 1)
+    
+//Wear-levelled warm-up progress log (see WARMUP.h), up to the checksum
+//Outside the CRC protected region, and counted as erased by the simple checksum
+#define EEPROM_WARMUP_LOG_ADDR (EEPROM_START + 0x100)
+#define EEPROM_WARMUP_LOG_SIZE (EEPROM_CKSM_H_ADDR - EEPROM_WARMUP_LOG_ADDR)
     
 #define EEPROM_CHECKSUM_GOOD 0x0000
     
     //Writes and verifies a byte to the EEPROM. Returns true if successful
     bool EEPROM_ByteWrite(uint16_t address, uint8_t data);
     
+    //Writes and verifies a byte while the supply is failing (power-fail flush only)
+    bool EEPROM_EmergencyByteWrite(uint16_t address, uint8_t data);
+    
+    //Stops any new writes, except EEPROM_EmergencyByteWrite
+    void EEPROM_WriteLock(void);
+    
     //Writes and verifies a 16-bit word to the EEPROM. Returns true if successful
     bool EEPROM_WordWrite(uint16_t address, uint16_t data);
     
@@ -0,0 +1,176 @@
+#include "ENV.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+
+//Temperature points of the correction table (degrees C)
+#define ENV_TEMP_POINTS 7
+static const int8_t tempAxis[ENV_TEMP_POINTS] = {-10, 0, 10, 20, 30, 40, 50};
+
+//Humidity points of the correction table (%RH)
+#define ENV_HUMIDITY_POINTS 3
+static const int8_t humidityAxis[ENV_HUMIDITY_POINTS] = {33, 65, 85};
+
+//R_S(T, RH) / R_S(20C, 65%RH) in Q10, from the MQ-137 temperature / humidity dependency curve
+static const uint16_t compTable[ENV_TEMP_POINTS][ENV_HUMIDITY_POINTS] = {
+    //33%RH  65%RH  85%RH
+    {1434, 1341, 1290},     //-10C
+    {1321, 1229, 1188},     //0C
+    {1198, 1116, 1075},     //10C
+    {1096, 1024, 983},      //20C
+    {1024, 952, 911},       //30C
+    {973, 901, 870},        //40C
+    {932, 870, 840},        //50C
+};
+
+static int16_t temperature = 20;
+static uint8_t humidity = ENV_HUMIDITY_DEFAULT;
+static uint16_t compFactor = ENV_FACTOR_ONE;
+static uint8_t envTicks = 0;
+
+//Linear interpolation between two table points
+static int16_t _interpolate(int16_t x, int16_t x0, int16_t x1, int16_t y0, int16_t y1)
+{
+    return y0 + (int16_t) ((((int32_t) (y1 - y0)) * (x - x0)) / (x1 - x0));
+}
+
+//Returns the index of the table segment containing x, and clamps x to the table
+static uint8_t _segmentFind(const int8_t* axis, uint8_t points, int16_t* x)
+{
+    if (*x <= axis[0])
+    {
+        *x = axis[0];
+        return 0;
+    }
+    else if (*x >= axis[points - 1])
+    {
+        *x = axis[points - 1];
+        return points - 2;
+    }
+
+    uint8_t index = 0;
+    while (*x > axis[index + 1])
+    {
+        index++;
+    }
+
+    return index;
+}
+
+//Bilinear interpolation of the correction table
+static uint16_t _compensationLookup(int16_t temp, int16_t rh)
+{
+    uint8_t t = _segmentFind(tempAxis, ENV_TEMP_POINTS, &temp);
+    uint8_t h = _segmentFind(humidityAxis, ENV_HUMIDITY_POINTS, &rh);
+
+    //Interpolate along humidity at both temperature points
+    int16_t low = _interpolate(rh, humidityAxis[h], humidityAxis[h + 1], compTable[t][h], compTable[t][h + 1]);
+    int16_t high = _interpolate(rh, humidityAxis[h], humidityAxis[h + 1], compTable[t + 1][h], compTable[t + 1][h + 1]);
+
+    //Then along temperature
+    return (uint16_t) _interpolate(temp, tempAxis[t], tempAxis[t + 1], low, high);
+}
+
+//Reads the internal temperature sensor, returns degrees C
+static int16_t _temperatureRead(void)
+{
+    //Save the ADC setup used by the gas sensors
+    uint8_t ctrlc = ADC0.CTRLC;
+    uint8_t ctrle = ADC0.CTRLE;
+
+    //The temperature sensor is characterized with the 1.024V reference
+    ADC0.CTRLC = (ctrlc & ~ADC_REFSEL_gm) | ADC_REFSEL_1V024_gc;
+    ADC0.CTRLE = ENV_TEMP_SAMPDUR;
+
+    //First conversion after changing the reference is discarded
+    ADC0_GetConversion(ADC_MUXPOS_TEMPSENSE_gc);
+    uint16_t result = ADC0_GetConversion(ADC_MUXPOS_TEMPSENSE_gc);
+
+    //Restore the gas sensor setup
+    ADC0.CTRLC = ctrlc;
+    ADC0.CTRLE = ctrle;
+
+    //Factory calibration (see device datasheet)
+    int32_t temp = ((int32_t) SIGROW.TEMPSENSE1) - result;
+    temp *= SIGROW.TEMPSENSE0;
+    temp += 0x0800;
+    temp >>= 12;
+
+    //Kelvin to C
+    return (int16_t) (temp - 273);
+}
+
+//Reads the relative humidity, in %
+static uint8_t _humidityRead(void)
+{
+#ifdef ENV_HUMIDITY_ADC_MUX
+    uint16_t result = ADC0_GetConversion(ENV_HUMIDITY_ADC_MUX);
+
+    if (result <= ENV_HUMIDITY_ZERO)
+    {
+        return 0;
+    }
+
+    uint16_t rh = (result - ENV_HUMIDITY_ZERO) / ENV_HUMIDITY_COUNTS_PER_PCT;
+    return (rh > 100) ? 100 : (uint8_t) rh;
+#else
+    return ENV_HUMIDITY_DEFAULT;
+#endif
+}
+
+//Measures the environment for the first time
+void ENV_Initialize(void)
+{
+    ENV_Measure();
+    envTicks = 0;
+}
+
+//Immediately measures the temperature and humidity (blocking!)
+void ENV_Measure(void)
+{
+    temperature = _temperatureRead();
+    humidity = _humidityRead();
+    compFactor = _compensationLookup(temperature, humidity);
+
+#ifdef PRINT_ENV_DATA
+    printf("Temperature = %d C, Humidity = %u %%RH, Correction = %u / 1024\r\n", temperature, humidity, compFactor);
+#endif
+}
+
+//Called once per tick, returns true if a new measurement was taken
+bool ENV_Service(void)
+{
+    envTicks++;
+
+    if (envTicks < ENV_SAMPLE_TICKS)
+    {
+        return false;
+    }
+
+    envTicks = 0;
+    ENV_Measure();
+
+    return true;
+}
+
+//Returns the last measured temperature in degrees C
+int16_t ENV_TemperatureGet(void)
+{
+    return temperature;
+}
+
+//Returns the last measured relative humidity in %
+uint8_t ENV_HumidityGet(void)
+{
+    return humidity;
+}
+
+//Returns the sensor correction R_S(T, RH) / R_S(20C, 65%RH) for the last measurement (Q10)
+uint16_t ENV_CompensationGet(void)
+{
+    return compFactor;
+}
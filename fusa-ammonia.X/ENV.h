@@ -0,0 +1,78 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef ENV_H
+#define	ENV_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Prints the measured temperature, humidity and correction
+//#define PRINT_ENV_DATA
+    
+//Number of 0.5s ticks between environment measurements (30s)
+//Temperature and humidity change slowly, and the measurement runs after the alarm checks
+#define ENV_SAMPLE_TICKS 60
+    
+//ADC0 sample duration for the internal temperature sensor
+#define ENV_TEMP_SAMPDUR 0x20
+    
+//Correction factor of 1.0 (Q10 fixed point)
+#define ENV_FACTOR_ONE 1024
+    
+//Humidity used when no external humidity sensor is connected (%RH)
+#define ENV_HUMIDITY_DEFAULT 65
+    
+//Uncomment to read an external analog humidity sensor on this ADC0 input
+//#define ENV_HUMIDITY_ADC_MUX ADC_MUXPOS_AIN5_gc
+    
+//Linear transfer function of the external humidity sensor (2.048V reference)
+//%RH = (ADC - ENV_HUMIDITY_ZERO) / ENV_HUMIDITY_COUNTS_PER_PCT
+#define ENV_HUMIDITY_ZERO 620
+#define ENV_HUMIDITY_COUNTS_PER_PCT 26
+    
+    //Measures the environment for the first time
+    void ENV_Initialize(void);
+    
+    //Immediately measures the temperature and humidity (blocking!)
+    void ENV_Measure(void);
+    
+    //Called once per tick, returns true if a new measurement was taken
+    bool ENV_Service(void);
+    
+    //Returns the last measured temperature in degrees C
+    int16_t ENV_TemperatureGet(void);
+    
+    //Returns the last measured relative humidity in %
+    uint8_t ENV_HumidityGet(void);
+    
+    //Returns the sensor correction R_S(T, RH) / R_S(20C, 65%RH) for the last measurement (Q10)
+    uint16_t ENV_CompensationGet(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ENV_H */
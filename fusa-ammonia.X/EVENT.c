@@ -0,0 +1,147 @@
+#include "EVENT.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "TIMING.h"
+
+#if ((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) != 0) || (EVENT_QUEUE_SIZE > 128)
+#error EVENT_QUEUE_SIZE must be a power of 2, up to 128
+#endif
+
+#define EVENT_INDEX_MASK (EVENT_QUEUE_SIZE - 1)
+
+//Stops the compiler moving accesses to the queue across the volatile index accesses
+#define EVENT_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+static event_t queue[EVENT_QUEUE_SIZE];
+
+//Free-running indexes - head is only written by EVENT_Post, tail only by EVENT_Get
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+
+//Statistics
+static volatile uint8_t dropCount[EVENT_TYPE_COUNT];
+static volatile uint8_t depthMax = 0;
+static uint32_t latencyMax[EVENT_TYPE_COUNT];
+
+//Empties the queue and clears the statistics
+void EVENT_Initialize(void)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        head = 0;
+        tail = 0;
+        depthMax = 0;
+
+        for (uint8_t i = 0; i < EVENT_TYPE_COUNT; i++)
+        {
+            dropCount[i] = 0;
+            latencyMax[i] = 0;
+        }
+    }
+}
+
+//Adds an event to the queue, returns false (and counts a drop) if full
+bool EVENT_Post(event_type_t type, uint8_t arg)
+{
+    uint32_t now = TIMING_TimestampGet();
+    bool isPosted = false;
+
+    //Producers can be the main loop and interrupts of either level
+    //The consumer never blocks, it only sees head once the entry is complete
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        uint8_t depth = (uint8_t) (head - tail);
+
+        if (depth >= EVENT_QUEUE_SIZE)
+        {
+            if (dropCount[type] < UINT8_MAX)
+            {
+                dropCount[type]++;
+            }
+        }
+        else
+        {
+            event_t* entry = &queue[head & EVENT_INDEX_MASK];
+            entry->time = now;
+            entry->type = type;
+            entry->arg = arg;
+
+            head++;
+            isPosted = true;
+
+            if (depth >= depthMax)
+            {
+                depthMax = depth + 1;
+            }
+        }
+    }
+
+    return isPosted;
+}
+
+//Removes the oldest event, returns false if the queue is empty (main loop only)
+bool EVENT_Get(event_t* event)
+{
+    uint8_t index = tail;
+
+    if (index == head)
+    {
+        return false;
+    }
+
+    //Not read before head shows the entry is complete
+    EVENT_BARRIER();
+
+    *event = queue[index & EVENT_INDEX_MASK];
+
+    //Release the entry after it has been copied, EVENT_Post may then overwrite it
+    EVENT_BARRIER();
+    tail = index + 1;
+
+    return true;
+}
+
+//Returns true if an event is waiting
+bool EVENT_IsPending(void)
+{
+    return (tail != head);
+}
+
+//Returns the number of events of a type dropped because the queue was full
+uint8_t EVENT_DropCountGet(event_type_t type)
+{
+    return dropCount[type];
+}
+
+//Records the time from posting to dispatch of an event
+void EVENT_LatencyUpdate(const event_t* event)
+{
+    uint32_t latency = TIMING_ElapsedGet(event->time);
+
+    if (latency > latencyMax[event->type])
+    {
+        latencyMax[event->type] = latency;
+    }
+}
+
+//Prints the dropped events, queue high-water mark and worst-case latency
+void EVENT_StatsPrint(void)
+{
+    static const char* const typeNames[EVENT_TYPE_COUNT] = {
+        "Tick", "Hour", "Memory scan"
+    };
+
+    printf("Events: queue peak = %u / %u\r\n", depthMax, EVENT_QUEUE_SIZE);
+
+    for (uint8_t i = 0; i < EVENT_TYPE_COUNT; i++)
+    {
+        printf("  %s: dropped = %u, worst latency = %lu us\r\n", typeNames[i],
+                dropCount[i], TIMING_TICKS_TO_US(latencyMax[i]));
+    }
+}
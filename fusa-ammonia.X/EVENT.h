@@ -0,0 +1,79 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef EVENT_H
+#define	EVENT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Prints the event statistics every hour
+//#define PRINT_EVENT_STATS
+    
+//Entries in the event queue (power of 2)
+#define EVENT_QUEUE_SIZE 8
+    
+    //Events signalled to the main loop
+    typedef enum {
+        EVENT_TICK = 0,         //PIT tick, runs the periodic self-check
+        EVENT_HOUR,             //RTC overflow, arg = warm-up hours
+        EVENT_MEMORY_SCAN,      //Memory verification requested (button / console)
+        EVENT_TYPE_COUNT
+    } event_type_t;
+    
+    //One entry of the event queue
+    typedef struct {
+        uint32_t time;          //TIMING timestamp when posted
+        uint8_t type;           //event_type_t
+        uint8_t arg;
+    } event_t;
+    
+    //Empties the queue and clears the statistics
+    void EVENT_Initialize(void);
+    
+    //Adds an event to the queue, returns false (and counts a drop) if full
+    //Safe to call from interrupts and from the main loop
+    bool EVENT_Post(event_type_t type, uint8_t arg);
+    
+    //Removes the oldest event, returns false if the queue is empty (main loop only)
+    bool EVENT_Get(event_t* event);
+    
+    //Returns true if an event is waiting
+    bool EVENT_IsPending(void);
+    
+    //Returns the number of events of a type dropped because the queue was full
+    uint8_t EVENT_DropCountGet(event_type_t type);
+    
+    //Records the time from posting to dispatch of an event
+    void EVENT_LatencyUpdate(const event_t* event);
+    
+    //Prints the dropped events, queue high-water mark and worst-case latency
+    void EVENT_StatsPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* EVENT_H */
@@ -0,0 +1,300 @@
+#include "FAULT.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+#include "application.h"
+#include "SENSOR.h"
+#include "EEPROM.h"
+#include "TIMING.h"
+
+#ifdef FUSA_FAULT_INJECTION
+
+typedef enum {
+    FAULT_PHASE_IDLE = 0, FAULT_PHASE_START, FAULT_PHASE_WAIT, FAULT_PHASE_INJECTED
+} fault_phase_t;
+
+static const char* const targetNames[FAULT_TARGET_COUNT] = {
+    "sysState", "sysStateCheck", "DACREF", "Heater PWM", "AC", "EEPROM"
+};
+
+static fault_phase_t phase = FAULT_PHASE_IDLE;
+static fault_target_t target = FAULT_SYS_STATE;
+static uint8_t run = 0;
+static uint8_t delayTicks = 0;
+static uint32_t injectedTicks = 0;
+static bool isDetected = false;
+
+//Location and original value of the injected fault
+static uint8_t faultMask = 0;
+static uint8_t faultChannel = 0;
+static uint16_t faultAddr = 0;
+static uint8_t faultValue = 0;
+static system_state_t faultState = SYS_ERROR;
+
+//Results per target
+static uint8_t injectedCount[FAULT_TARGET_COUNT];
+static uint8_t detectedCount[FAULT_TARGET_COUNT];
+static uint32_t latencySum[FAULT_TARGET_COUNT];
+static uint32_t latencyMax[FAULT_TARGET_COUNT];
+
+static uint16_t randomState = 0xACE1;
+
+//16-bit xorshift
+static uint16_t _randomGet(void)
+{
+    randomState ^= randomState << 7;
+    randomState ^= randomState >> 9;
+    randomState ^= randomState << 8;
+    return randomState;
+}
+
+//Injects a fault into the current target
+static void _faultInject(void)
+{
+    faultMask = 1 << (_randomGet() % 8);
+    faultChannel = _randomGet() % SENSOR_CHANNEL_COUNT;
+    faultState = FUSA_SystemStateGet();
+
+    AC_t* ac = SENSOR_ChannelConfigGet(faultChannel)->ac;
+
+    switch (target)
+    {
+        case FAULT_SYS_STATE:
+        case FAULT_SYS_STATE_CHECK:
+        {
+            FUSA_StateFaultInject(faultMask, (target == FAULT_SYS_STATE_CHECK));
+            break;
+        }
+        case FAULT_DACREF:
+        {
+            faultValue = ac->DACREF;
+            ac->DACREF = faultValue ^ faultMask;
+            break;
+        }
+        case FAULT_HEATER_PWM:
+        {
+            faultValue = TCA0.SINGLE.CMP0BUF;
+            TCA0.SINGLE.CMP0BUF = faultValue ^ faultMask;
+            break;
+        }
+        case FAULT_AC:
+        {
+            faultValue = ac->CTRLA;
+            ac->CTRLA = faultValue & ~AC_ENABLE_bm;
+            break;
+        }
+        case FAULT_EEPROM:
+        default:
+        {
+            faultAddr = DIAG_EEPROM_START_ADDR + (_randomGet() % DIAG_EEPROM_LENGTH);
+            faultValue = EEPROM_ByteRead(faultAddr);
+            EEPROM_ByteWrite(faultAddr, faultValue ^ faultMask);
+            break;
+        }
+    }
+}
+
+//Removes the injected fault
+static void _faultRepair(void)
+{
+    AC_t* ac = SENSOR_ChannelConfigGet(faultChannel)->ac;
+
+    switch (target)
+    {
+        case FAULT_SYS_STATE:
+        case FAULT_SYS_STATE_CHECK:
+        {
+            FUSA_StateFaultInject(faultMask, (target == FAULT_SYS_STATE_CHECK));
+            break;
+        }
+        case FAULT_DACREF:
+        {
+            ac->DACREF = faultValue;
+            break;
+        }
+        case FAULT_HEATER_PWM:
+        {
+            TCA0.SINGLE.CMP0BUF = faultValue;
+            break;
+        }
+        case FAULT_AC:
+        {
+            ac->CTRLA = faultValue;
+            break;
+        }
+        case FAULT_EEPROM:
+        default:
+        {
+            EEPROM_ByteWrite(faultAddr, faultValue);
+            break;
+        }
+    }
+}
+
+//Waits a random number of ticks before the next injection
+static void _delayStart(void)
+{
+    delayTicks = 1 + (_randomGet() % FAULT_DELAY_TICKS_MAX);
+    phase = FAULT_PHASE_WAIT;
+}
+
+//Moves on to the next run of the campaign
+static void _runNext(void)
+{
+    run++;
+
+    if (run >= FAULT_CAMPAIGN_RUNS)
+    {
+        run = 0;
+        target++;
+    }
+
+    if (target >= FAULT_TARGET_COUNT)
+    {
+        phase = FAULT_PHASE_IDLE;
+        FAULT_ReportPrint();
+        return;
+    }
+
+    _delayStart();
+}
+
+//Starts a fault injection campaign once the system is monitoring
+void FAULT_CampaignStart(void)
+{
+    for (uint8_t i = 0; i < FAULT_TARGET_COUNT; i++)
+    {
+        injectedCount[i] = 0;
+        detectedCount[i] = 0;
+        latencySum[i] = 0;
+        latencyMax[i] = 0;
+    }
+
+    target = FAULT_SYS_STATE;
+    run = 0;
+    phase = FAULT_PHASE_START;
+}
+
+//Called at the end of each tick, injects / times out faults
+void FAULT_Service(void)
+{
+    switch (phase)
+    {
+        case FAULT_PHASE_START:
+        {
+            //All diagnostics are active while monitoring
+            if (FUSA_SystemStateGet() == SYS_MONITOR)
+            {
+                printf("Starting fault injection campaign\r\n");
+                randomState ^= (uint16_t) TIMING_TimestampGet();
+                _delayStart();
+            }
+            break;
+        }
+        case FAULT_PHASE_WAIT:
+        {
+            if (FUSA_SystemStateGet() != SYS_MONITOR)
+            {
+                break;
+            }
+
+            delayTicks--;
+            if (delayTicks == 0)
+            {
+                _faultInject();
+                injectedCount[target]++;
+                injectedTicks = 0;
+                isDetected = false;
+                phase = FAULT_PHASE_INJECTED;
+            }
+            break;
+        }
+        case FAULT_PHASE_INJECTED:
+        {
+            injectedTicks++;
+
+            if (isDetected)
+            {
+                //A failed AC test leaves the system in SYS_SELF_TEST
+                if (FUSA_SystemStateGet() == SYS_SELF_TEST)
+                {
+                    FUSA_SystemStateSet(faultState);
+                }
+
+                _runNext();
+            }
+            else if (injectedTicks >= ((target == FAULT_EEPROM) ? FAULT_EEPROM_TIMEOUT_TICKS : FAULT_TIMEOUT_TICKS))
+            {
+                //Missed
+                printf("Fault not detected: %s, mask 0x%x\r\n", targetNames[target], faultMask);
+                _faultRepair();
+                _runNext();
+            }
+            break;
+        }
+        case FAULT_PHASE_IDLE:
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//Called on a state change, returns true if it was caused by an injected fault
+bool FAULT_StateIntercept(system_state_t state)
+{
+    if (phase != FAULT_PHASE_INJECTED)
+    {
+        return false;
+    }
+
+    //A corrupted EEPROM requires re-calibration instead of a system fault
+    if ((state != SYS_ERROR) && !((target == FAULT_EEPROM) && (state == SYS_CALIBRATE)))
+    {
+        return false;
+    }
+
+    //Later errors in the same tick are caused by the same fault
+    if (!isDetected)
+    {
+        isDetected = true;
+        _faultRepair();
+
+        uint32_t latency = injectedTicks + 1;
+        detectedCount[target]++;
+        latencySum[target] += latency;
+        if (latency > latencyMax[target])
+        {
+            latencyMax[target] = latency;
+        }
+    }
+
+    return true;
+}
+
+//Prints the detection coverage and latency of each target
+void FAULT_ReportPrint(void)
+{
+    printf("Fault injection results:\r\n");
+
+    for (uint8_t i = 0; i < FAULT_TARGET_COUNT; i++)
+    {
+        printf("  %s: %u / %u detected", targetNames[i], detectedCount[i], injectedCount[i]);
+
+        if (detectedCount[i] != 0)
+        {
+            //Latency in 0.5s ticks
+            printf(", latency avg = %lu ms, max = %lu ms",
+                    (latencySum[i] * 500UL) / detectedCount[i], latencyMax[i] * 500UL);
+        }
+
+        printf("\r\n");
+    }
+}
+
+#endif
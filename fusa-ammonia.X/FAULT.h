@@ -0,0 +1,81 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef FAULT_H
+#define	FAULT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "fusa.h"
+    
+#ifdef FUSA_FAULT_INJECTION
+    
+#ifndef DEVELOP_MODE
+#error Fault injection is only allowed in develop builds
+#endif
+    
+//Number of faults injected into each target by a campaign
+#define FAULT_CAMPAIGN_RUNS 20
+    
+//Maximum delay before each injection, in 0.5s ticks
+#define FAULT_DELAY_TICKS_MAX 8
+    
+//Ticks to wait for detection before a fault is counted as missed
+#define FAULT_TIMEOUT_TICKS 20
+    
+//The EEPROM is only verified by the memory scan
+#define FAULT_EEPROM_TIMEOUT_TICKS (2UL * 3600UL * 2UL)
+    
+    //Locations faults are injected into
+    typedef enum {
+        FAULT_SYS_STATE = 0,        //Bit flip in sysState
+        FAULT_SYS_STATE_CHECK,      //Bit flip in sysStateCheck
+        FAULT_DACREF,               //Bit flip in the DACREF of a channel
+        FAULT_HEATER_PWM,           //Bit flip in the heater duty cycle (CMP0BUF)
+        FAULT_AC,                   //Comparator of a channel disabled
+        FAULT_EEPROM,               //Bit flip in the CRC protected EEPROM region
+        FAULT_TARGET_COUNT
+    } fault_target_t;
+    
+    //Starts a fault injection campaign once the system is monitoring
+    void FAULT_CampaignStart(void);
+    
+    //Called at the end of each tick, injects / times out faults
+    void FAULT_Service(void);
+    
+    //Called on a state change, returns true if it was caused by an injected fault
+    bool FAULT_StateIntercept(system_state_t state);
+    
+    //Prints the detection coverage and latency of each target
+    void FAULT_ReportPrint(void);
+    
+#endif
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FAULT_H */
@@ -0,0 +1,202 @@
+#include "HEATER.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+
+//Energy units (mW * % * 0.5s) in one mWh
+#define HEATER_UNITS_PER_MWH (100UL * 2UL * 3600UL)
+
+//Pre-heat profile - the sensor reaches temperature faster at full power
+static const heater_profile_step_t preheatProfile[] = {
+    {HEATER_MINUTES_TO_TICKS(10), 100},
+    {HEATER_MINUTES_TO_TICKS(5), 95},
+    {HEATER_MINUTES_TO_TICKS(5), 90},
+};
+
+#define HEATER_PROFILE_STEPS (sizeof(preheatProfile) / sizeof(preheatProfile[0]))
+
+static heater_phase_t phase = HEATER_OFF;
+static uint8_t profileStep = 0;
+static uint32_t stepTicks = 0;
+static uint8_t duty = 0;
+
+//Expected value of CMP0, and its complement for verification
+static uint8_t heaterCompare = 0;
+static uint8_t heaterCompareCheck = 0xFF;
+
+//Energy accounting
+static uint32_t energyUnits = 0;
+static uint32_t energyMWh = 0;
+static uint32_t energyPrinted = 0;
+
+//Sets the duty cycle of the heater (%)
+static void _dutySet(uint8_t percent)
+{
+    if (percent > 100)
+    {
+        percent = 100;
+    }
+
+    duty = percent;
+
+    //CMP0 > PER is a constant high output
+    heaterCompare = (uint8_t) ((((uint16_t) percent * (HEATER_PWM_PER + 1)) + 50) / 100);
+    heaterCompareCheck = ~heaterCompare;
+
+    //Buffered, updates at the end of the PWM period
+    TCA0.SINGLE.CMP0BUF = heaterCompare;
+}
+
+//Starts the heater PWM and the pre-heat profile
+void HEATER_Start(void)
+{
+    phase = HEATER_PREHEAT;
+    profileStep = 0;
+    stepTicks = 0;
+
+    _dutySet(preheatProfile[0].duty);
+    TCA0.SINGLE.CMP0 = heaterCompare;
+
+    //Connect WO0 to the heater pin
+    HEATER_SetLow();
+    TCA0.SINGLE.CTRLB |= TCA_SINGLE_CMP0EN_bm;
+
+    //The timer runs continuously, the buzzer is gated separately
+    TCA0_Start();
+}
+
+//Turns the heater off
+void HEATER_Off(void)
+{
+    TCA0.SINGLE.CTRLB &= ~TCA_SINGLE_CMP0EN_bm;
+    HEATER_SetLow();
+
+    phase = HEATER_OFF;
+    duty = 0;
+}
+
+//Called once per tick, advances the pre-heat profile
+void HEATER_Service(void)
+{
+    if (phase == HEATER_OFF)
+    {
+        return;
+    }
+
+    //Energy used in the last tick
+    energyUnits += HEATER_POWER_FULL_MW * duty;
+    while (energyUnits >= HEATER_UNITS_PER_MWH)
+    {
+        energyUnits -= HEATER_UNITS_PER_MWH;
+        energyMWh++;
+    }
+
+    if (phase != HEATER_PREHEAT)
+    {
+        return;
+    }
+
+    stepTicks++;
+
+    if (stepTicks < preheatProfile[profileStep].ticks)
+    {
+        return;
+    }
+
+    //Next step of the profile
+    stepTicks = 0;
+    profileStep++;
+
+    if (profileStep < HEATER_PROFILE_STEPS)
+    {
+        _dutySet(preheatProfile[profileStep].duty);
+    }
+    else
+    {
+        //Pre-heat complete
+        phase = HEATER_RUN;
+        _dutySet(HEATER_DUTY_RUN);
+
+        printf("Heater pre-heat complete.\r\n");
+    }
+}
+
+//Verifies the heater PWM is configured as expected
+diag_result_t HEATER_Verify(void)
+{
+    //Variable corrupted
+    if (heaterCompare != (uint8_t) (~heaterCompareCheck))
+    {
+        return DIAG_FAIL;
+    }
+
+    if (phase == HEATER_OFF)
+    {
+        return DIAG_PASS;
+    }
+
+    //Timer must be running, in single slope PWM, with WO0 enabled
+    if (!(TCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm))
+    {
+        return DIAG_FAIL;
+    }
+    else if ((TCA0.SINGLE.CTRLB & (TCA_SINGLE_WGMODE_gm | TCA_SINGLE_CMP0EN_bm)) !=
+            (TCA_SINGLE_WGMODE_SINGLESLOPE_gc | TCA_SINGLE_CMP0EN_bm))
+    {
+        return DIAG_FAIL;
+    }
+    else if (TCA0.SINGLE.PER != HEATER_PWM_PER)
+    {
+        return DIAG_FAIL;
+    }
+
+    //Pending duty cycle, or active duty cycle
+    if ((TCA0.SINGLE.CMP0BUF != heaterCompare) || (TCA0.SINGLE.CMP0 != heaterCompare))
+    {
+        return DIAG_FAIL;
+    }
+
+    //WO0 must be routed to PORTD, and the heater pin must be an output
+    if ((PORTMUX.TCAROUTEA & PORTMUX_TCA0_gm) != PORTMUX_TCA0_PORTD_gc)
+    {
+        return DIAG_FAIL;
+    }
+    else if (!(VPORTD.DIR & PIN0_bm))
+    {
+        return DIAG_FAIL;
+    }
+
+    return DIAG_PASS;
+}
+
+//Returns the phase of the heater
+heater_phase_t HEATER_PhaseGet(void)
+{
+    return phase;
+}
+
+//Returns the current duty cycle (%)
+uint8_t HEATER_DutyGet(void)
+{
+    return duty;
+}
+
+//Returns the estimated heater energy since start-up (mWh)
+uint32_t HEATER_EnergyGet(void)
+{
+    return energyMWh;
+}
+
+//Prints the estimated heater energy and average power
+void HEATER_StatsPrint(void)
+{
+    //Called once per hour, so mWh in the last hour = average mW
+    printf("Heater: duty = %u%%, average = %lu mW, total = %lu mWh\r\n",
+            duty, energyMWh - energyPrinted, energyMWh);
+
+    energyPrinted = energyMWh;
+}
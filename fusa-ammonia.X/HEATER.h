@@ -0,0 +1,89 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef HEATER_H
+#define	HEATER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+//Prints the heater energy use every hour
+//#define PRINT_HEATER_STATS
+    
+//The heater (PD0) is driven by TCA0 WO0, sharing the timer with the buzzer (WO1)
+//PER is set by MCC for the buzzer tone, CLK_PER / 64 / 52 = ~1 kHz
+#define HEATER_PWM_PER 0x33
+    
+//Number of 0.5s ticks in a minute
+#define HEATER_MINUTES_TO_TICKS(min) ((min) * 120UL)
+    
+//Duty cycle (%) after the pre-heat profile
+//Calibrate the sensor at the same duty cycle
+#define HEATER_DUTY_RUN 85
+    
+//Heater power at 100% duty cycle (mW) - 5V across the ~31R MQ-137 heater
+#define HEATER_POWER_FULL_MW 800UL
+    
+    typedef enum {
+        HEATER_OFF = 0, HEATER_PREHEAT, HEATER_RUN
+    } heater_phase_t;
+    
+    //One step of the pre-heat profile
+    typedef struct {
+        uint32_t ticks;     //Length of the step, in 0.5s ticks
+        uint8_t duty;       //Duty cycle of the step (%)
+    } heater_profile_step_t;
+    
+    //Starts the heater PWM and the pre-heat profile
+    void HEATER_Start(void);
+    
+    //Turns the heater off
+    void HEATER_Off(void);
+    
+    //Called once per tick, advances the pre-heat profile
+    void HEATER_Service(void);
+    
+    //Verifies the heater PWM is configured as expected
+    diag_result_t HEATER_Verify(void);
+    
+    //Returns the phase of the heater
+    heater_phase_t HEATER_PhaseGet(void);
+    
+    //Returns the current duty cycle (%)
+    uint8_t HEATER_DutyGet(void);
+    
+    //Returns the estimated heater energy since start-up (mWh)
+    uint32_t HEATER_EnergyGet(void);
+    
+    //Prints the estimated heater energy and average power
+    void HEATER_StatsPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HEATER_H */
@@ -0,0 +1,46 @@
+#include "LOG.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+
+#ifdef LOG_TOKENIZED
+
+//Sends a value, little endian
+static void _bytesSend(uint32_t value, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        putchar((uint8_t) value);
+        value >>= 8;
+    }
+}
+
+//Sends a tokenized message: LOG_SYNC, ID (16-bit), argument count, arguments
+void LOG_TokenSend(log_id_t id, uint8_t count, uint32_t a, uint32_t b, uint32_t c)
+{
+    putchar(LOG_SYNC);
+    _bytesSend((uint16_t) id, 2);
+    putchar(count);
+
+    const uint32_t args[3] = {a, b, c};
+    for (uint8_t i = 0; i < count; i++)
+    {
+        _bytesSend(args[i], 4);
+    }
+}
+
+#else
+
+//Format strings, indexed by log_id_t
+#define LOG_FORMAT(id, format) format,
+const char* const logFormats[LOG_ID_COUNT] = {
+    LOG_MESSAGES(LOG_FORMAT)
+};
+#undef LOG_FORMAT
+
+#endif
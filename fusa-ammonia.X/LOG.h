@@ -0,0 +1,136 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef LOG_H
+#define	LOG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+    
+//If defined, messages are sent as a 16-bit ID and binary arguments instead of text
+//Decode with tools/log_decode.py, using this file as the string table
+//#define LOG_TOKENIZED
+    
+//Start of a tokenized message - never sent in text
+#define LOG_SYNC 0xFF
+    
+//Messages, in ID order - only append, or the IDs of existing messages change
+//Arguments must be integers of up to 32 bits
+#define LOG_MESSAGES(X) \
+    X(LOG_PASS, "OK\r\n") \
+    X(LOG_FAIL, "FAIL\r\n") \
+    X(LOG_SELF_TEST_START, "\r\nRunning Self Test\r\n") \
+    X(LOG_CONFIG_ERASED, "Configuration ERASED\r\n") \
+    X(LOG_FLASH_CHECKSUM, "Flash Memory Checksum = 0x%lx\r\n\r\n") \
+    X(LOG_TEST_CPU, "Testing CPU...") \
+    X(LOG_TEST_WDT, "Testing WDT...") \
+    X(LOG_TEST_SRAM, "Testing SRAM...") \
+    X(LOG_TEST_MEMORY, "Testing Memory Integrity...") \
+    X(LOG_TEST_AC, "Testing Analog Comparator...") \
+    X(LOG_TEST_CALIBRATION, "Calibration data...") \
+    X(LOG_INVALID, "INVALID\r\n") \
+    X(LOG_SELF_TEST_CONTINUE, "\r\nWARNING: Start-up test failed. Continuing startup...\r\n") \
+    X(LOG_SELF_TEST_FAILED, "Self Test Failed\r\n\r\n") \
+    X(LOG_SELF_TEST_COMPLETE, "Self Test Complete\r\n\r\nBeginning %u hour sensor warmup\r\n") \
+    X(LOG_ADC_RESULT, "CH%u ADC Result: 0x%x\r\n") \
+    X(LOG_SRAM_ERROR, "SRAM Failed Self-Test\r\n") \
+    X(LOG_STATE_ERROR, "State Machine RAM Error\r\n") \
+    X(LOG_DACREF_ERROR, "DACREF Register Error\r\n") \
+    X(LOG_HEATER_ERROR, "Heater PWM Error\r\n") \
+    X(LOG_WDT_ERROR, "WDT Configuration Error\r\n") \
+    X(LOG_STACK_ERROR, "Stack Usage Error\r\n") \
+    X(LOG_CPU_ERROR, "CPU Failure\r\n") \
+    X(LOG_WARMUP_COMPLETE, "\r\nWarmup complete.\r\n") \
+    X(LOG_CALIBRATION_NOT_FOUND, "Calibration data not found. Press SW0 to set new zero-point.\r\n") \
+    X(LOG_CALIBRATION_RUNNING, "Running calibration.\r\n") \
+    X(LOG_CALIBRATION_COMPLETE, "Calibration complete. System is now ready.\r\n") \
+    X(LOG_CALIBRATION_FAILED, "Calibration failed to complete.\r\n") \
+    X(LOG_CURVE_START, "Gas curve calibration. Apply %u ppm reference gas, then press SW0.\r\n") \
+    X(LOG_CURVE_CAPTURE_FAILED, "Unable to capture point. Gas curve is unchanged.\r\n") \
+    X(LOG_CURVE_NEXT, "Apply %u ppm reference gas, then press SW0.\r\n") \
+    X(LOG_CURVE_COMPLETE, "Gas curve calibration complete.\r\n") \
+    X(LOG_CURVE_FAILED, "Gas curve calibration failed. Gas curve is unchanged.\r\n") \
+    X(LOG_MONITOR_PPM, "[MONITOR] CH%u Estimated Ammonia: %u ppm\r\n") \
+    X(LOG_ALARM_TRIPPED, "Alarm is tripped!\r\n") \
+    X(LOG_AC_ERROR, "AC failed self-check.\r\n") \
+    X(LOG_RECALIBRATE, "Ready to recalibrate. Press SW0 to set new zero-point, or TEST to calibrate the gas curve.\r\n") \
+    X(LOG_ALARM_PPM, "[ALARM] CH%u Estimated Ammonia: %u ppm\r\n") \
+    X(LOG_ALARM_CLEARED, "Alarm has cleared!\r\n") \
+    X(LOG_INVARIANT_ERROR, "State Machine Invariant Error\r\n") \
+    X(LOG_FLASH_ERROR, "FLASH has failed self test\r\n") \
+    X(LOG_EEPROM_ERROR, "EERPOM has failed self test\r\n") \
+    X(LOG_SYSTEM_FAULT, "SYSTEM FAULT\r\n") \
+    X(LOG_DACREF_HIGH_MAX, "WARNING: setPtHigh, DACREF at maximum.\r\n") \
+    X(LOG_DACREF_LOW_MAX, "WARNING: setPtLow, DACREF at maximum.\r\n") \
+    X(LOG_EEPROM_CRC, "CRC Checksum = 0x%x\r\n") \
+    X(LOG_EEPROM_VERIFIED, "EEPROM Verified\r\n") \
+    X(LOG_EEPROM_WRITE_ERROR, "An error occurred when writing EEPROM.\r\n") \
+    X(LOG_BASELINE_LIMIT, "CH%u: Baseline drift limit reached. Recalibration required.\r\n") \
+    X(LOG_BASELINE_UPDATED, "Baseline updated.\r\n") \
+    X(LOG_CURVE_POINT, "CH%u: %u ppm at R_S / R_0 = %u / 4096\r\n") \
+    X(LOG_FLASH_SEGMENT_ERROR, "FLASH segment %u (0x%x) has failed self test\r\n") \
+    X(LOG_ALARM_PATH_ERROR, "Hardware Alarm Path Error\r\n") \
+    X(LOG_AC_CHAR_ERROR, "AC characterisation failed.\r\n") \
+    X(LOG_ADC_MISMATCH, "CH%u: ADC0 (%u) and AC1 / DAC0 (%u) disagree\r\n") \
+    X(LOG_WARMUP_CREDIT, "Warm-up credit: %u of %u min, heater off for about %u min\r\n") \
+    X(LOG_AC_DRIFT, "WARNING: AC1 has drifted, trip = %u, rise = %lu ns, fall = %lu ns\r\n") \
+    X(LOG_HEATER_EARLY, "Heater on, remaining self-tests run during pre-heat\r\n") \
+    
+#define LOG_ID(id, format) id,
+    typedef enum {
+        LOG_MESSAGES(LOG_ID)
+        LOG_ID_COUNT
+    } log_id_t;
+#undef LOG_ID
+    
+#ifdef LOG_TOKENIZED
+    
+//Sends the ID and the arguments (32-bit, little endian)
+#define LOG_0(id) LOG_TokenSend((id), 0, 0, 0, 0)
+#define LOG_1(id, a) LOG_TokenSend((id), 1, (uint32_t) (a), 0, 0)
+#define LOG_2(id, a, b) LOG_TokenSend((id), 2, (uint32_t) (a), (uint32_t) (b), 0)
+#define LOG_3(id, a, b, c) LOG_TokenSend((id), 3, (uint32_t) (a), (uint32_t) (b), (uint32_t) (c))
+    
+    //Sends a tokenized message: LOG_SYNC, ID (16-bit), argument count, arguments
+    void LOG_TokenSend(log_id_t id, uint8_t count, uint32_t a, uint32_t b, uint32_t c);
+    
+#else
+    
+//Formats the message on the device
+#define LOG_0(id) printf(logFormats[(id)])
+#define LOG_1(id, a) printf(logFormats[(id)], (a))
+#define LOG_2(id, a, b) printf(logFormats[(id)], (a), (b))
+#define LOG_3(id, a, b, c) printf(logFormats[(id)], (a), (b), (c))
+    
+    extern const char* const logFormats[LOG_ID_COUNT];
+    
+#endif
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* LOG_H */
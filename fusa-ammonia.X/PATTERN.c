@@ -0,0 +1,170 @@
+#include "PATTERN.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "application.h"
+
+#define PATTERN_MS(ms) ((uint8_t) ((ms) / PATTERN_TICK_MS))
+
+static const pattern_step_t heartbeatSteps[] = {
+    {PATTERN_LED, PATTERN_MS(10)},
+    {0, PATTERN_MS(990)},
+};
+
+static const pattern_step_t alarmSteps[] = {
+    {PATTERN_LED, PATTERN_MS(500)},
+    {0, PATTERN_MS(500)},
+};
+
+static const pattern_step_t faultSteps[] = {
+    {PATTERN_LED | PATTERN_BUZZER, PATTERN_MS(600)},
+    {0, PATTERN_MS(200)},
+};
+
+//Steps, number of steps, and the outputs owned by each pattern
+static const struct {
+    const pattern_step_t* steps;
+    uint8_t count;
+    uint8_t outputs;
+} patterns[PATTERN_COUNT] = {
+    {NULL, 0, 0},
+    {heartbeatSteps, 2, PATTERN_LED},
+    {alarmSteps, 2, PATTERN_LED},
+    {faultSteps, 2, PATTERN_LED | PATTERN_BUZZER},
+};
+
+static volatile pattern_t pattern = PATTERN_OFF;
+static volatile uint8_t step = 0;
+static volatile uint8_t stepTicks = 0;
+static volatile uint8_t cycleCount = 0;
+
+//Drives the outputs owned by the pattern
+static void _outputsSet(uint8_t owned, uint8_t outputs)
+{
+    if (owned & PATTERN_LED)
+    {
+        if (outputs & PATTERN_LED)
+        {
+            LED0_SetHigh();
+        }
+        else
+        {
+            LED0_SetLow();
+        }
+    }
+
+    if (owned & PATTERN_BUZZER)
+    {
+        if (outputs & PATTERN_BUZZER)
+        {
+            BUZZER_ENABLE();
+        }
+        else
+        {
+            BUZZER_DISABLE();
+        }
+    }
+}
+
+ISR(TCB2_INT_vect)
+{
+    PATTERN_TCB.INTFLAGS = TCB_CAPT_bm;
+
+    if (pattern == PATTERN_OFF)
+    {
+        return;
+    }
+
+    stepTicks++;
+
+    if (stepTicks < patterns[pattern].steps[step].ticks)
+    {
+        return;
+    }
+
+    //Next step
+    stepTicks = 0;
+    step++;
+
+    if (step >= patterns[pattern].count)
+    {
+        step = 0;
+        cycleCount++;
+    }
+
+    _outputsSet(patterns[pattern].outputs, patterns[pattern].steps[step].outputs);
+}
+
+//Starts the step timer, playing PATTERN_OFF
+void PATTERN_Initialize(void)
+{
+    pattern = PATTERN_OFF;
+
+    PATTERN_TCB.CTRLB = TCB_CNTMODE_INT_gc;
+    PATTERN_TCB.CCMP = PATTERN_TICK_CCMP;
+    PATTERN_TCB.CNT = 0x0000;
+
+    PATTERN_TCB.INTFLAGS = TCB_CAPT_bm;
+    PATTERN_TCB.INTCTRL = TCB_CAPT_bm;
+
+    PATTERN_TCB.CTRLA = PATTERN_TCB_CLKSEL | TCB_ENABLE_bm;
+}
+
+//Plays a pattern from its first step, unless it is already playing
+void PATTERN_Play(pattern_t newPattern)
+{
+    if ((newPattern == pattern) || (newPattern >= PATTERN_COUNT))
+    {
+        return;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        //Release the outputs of the previous pattern
+        _outputsSet(patterns[pattern].outputs & ~patterns[newPattern].outputs, 0);
+
+        pattern = newPattern;
+        step = 0;
+        stepTicks = 0;
+        cycleCount = 0;
+
+        if (newPattern != PATTERN_OFF)
+        {
+            _outputsSet(patterns[newPattern].outputs, patterns[newPattern].steps[0].outputs);
+        }
+    }
+}
+
+//Returns the pattern being played
+pattern_t PATTERN_Get(void)
+{
+    return pattern;
+}
+
+//Returns the number of times the pattern has been completed since it was started
+uint8_t PATTERN_CycleCountGet(void)
+{
+    return cycleCount;
+}
+
+//Keeps the step tick at PATTERN_TICK_MS when CLK_PER is a multiple of F_CPU
+void PATTERN_ScaleSet(uint8_t scale)
+{
+    if (scale == 0)
+    {
+        scale = 1;
+    }
+
+    //Keep the position within the current step tick, so the counter never passes the new compare value
+    uint16_t period = PATTERN_TCB.CCMP + 1;
+    uint32_t count = (((uint32_t) PATTERN_TCB.CNT) * (PATTERN_TICK_CCMP + 1UL) * scale) / period;
+
+    PATTERN_TCB.CCMP = (uint16_t) (((PATTERN_TICK_CCMP + 1UL) * scale) - 1);
+    PATTERN_TCB.CNT = (uint16_t) count;
+}
@@ -0,0 +1,81 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef PATTERN_H
+#define	PATTERN_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Timer of the pattern sequencer
+#define PATTERN_TCB TCB2
+#define PATTERN_TCB_CLKSEL TCB_CLKSEL_DIV2_gc
+    
+//Resolution of the pattern steps (ms)
+#define PATTERN_TICK_MS 10
+    
+//Compare value for one step tick - CLK_PER / 2, at F_CPU (multiplied by the CPUCLK scale when boosted)
+#define PATTERN_TICK_CCMP ((uint16_t) (((F_CPU / 2UL) / (1000UL / PATTERN_TICK_MS)) - 1))
+    
+//Outputs driven by a pattern step
+#define PATTERN_LED 0x01
+#define PATTERN_BUZZER 0x02
+    
+    //Cadences played on the LED / buzzer
+    typedef enum {
+        PATTERN_OFF = 0,        //Outputs released
+        PATTERN_HEARTBEAT,      //Monitoring: short LED flash
+        PATTERN_ALARM,          //Alarm: LED blinking, the buzzer is driven by the state machine
+        PATTERN_FAULT,          //System failure: LED and buzzer, 600 ms on / 200 ms off
+        PATTERN_COUNT
+    } pattern_t;
+    
+    //One step of a pattern
+    typedef struct {
+        uint8_t outputs;        //PATTERN_LED / PATTERN_BUZZER set during the step
+        uint8_t ticks;          //Duration (PATTERN_TICK_MS)
+    } pattern_step_t;
+    
+    //Starts the step timer, playing PATTERN_OFF
+    void PATTERN_Initialize(void);
+    
+    //Plays a pattern from its first step, unless it is already playing
+    void PATTERN_Play(pattern_t pattern);
+    
+    //Returns the pattern being played
+    pattern_t PATTERN_Get(void);
+    
+    //Returns the number of times the pattern has been completed since it was started
+    uint8_t PATTERN_CycleCountGet(void);
+    
+    //Keeps the step tick at PATTERN_TICK_MS when CLK_PER is a multiple of F_CPU
+    //Call with interrupts disabled, as CLK_PER changes
+    void PATTERN_ScaleSet(uint8_t scale);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PATTERN_H */
@@ -0,0 +1,136 @@
+#include "PFM.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "mcc_generated_files/diagnostics/diag_library/memory/non_volatile/diag_flash_crc32.h"
+#include "TIMING.h"
+
+#if ((PFM_SEGMENT_COUNT * PFM_SEGMENT_SIZE) < PFM_SEGMENT_TABLE_ADDR)
+#error The flash segments do not cover the application region
+#elif (((PFM_SEGMENT_COUNT - 1) * PFM_SEGMENT_SIZE) >= PFM_SEGMENT_TABLE_ADDR)
+#error PFM_SEGMENT_COUNT has an empty segment
+#endif
+
+//Next segment of the in-order scan, and of the priority scan
+static uint8_t nextSegment = 0;
+static uint8_t nextPriority = 0;
+static bool isPriorityTurn = false;
+
+static uint8_t failedSegment = PFM_SEGMENT_NONE;
+
+//Full pass timing
+static uint32_t passStart = 0;
+static uint32_t passTime = 0;
+
+//Returns the next segment in the priority set at or after segment
+static uint8_t _priorityNext(uint8_t segment)
+{
+    for (uint8_t i = 0; i < PFM_SEGMENT_COUNT; i++)
+    {
+        if (segment >= PFM_SEGMENT_COUNT)
+        {
+            segment = 0;
+        }
+
+        if (PFM_PRIORITY_SEGMENTS & (1UL << segment))
+        {
+            return segment;
+        }
+
+        segment++;
+    }
+
+    return PFM_SEGMENT_NONE;
+}
+
+//Starts the segmented scan from the first segment
+void PFM_Initialize(void)
+{
+    nextSegment = 0;
+    nextPriority = _priorityNext(0);
+    isPriorityTurn = false;
+    failedSegment = PFM_SEGMENT_NONE;
+    passStart = TIMING_TimestampGet();
+}
+
+//Checks the CRC of one segment against the table
+diag_result_t PFM_SegmentVerify(uint8_t segment)
+{
+    if (segment >= PFM_SEGMENT_COUNT)
+    {
+        return DIAG_INVALID_ARG;
+    }
+
+    flash_address_t start = PFM_SegmentAddressGet(segment);
+    uint32_t length = PFM_SEGMENT_SIZE;
+
+    //The last segment ends at the table
+    if ((start + length) > PFM_SEGMENT_TABLE_ADDR)
+    {
+        length = PFM_SEGMENT_TABLE_ADDR - start;
+    }
+
+    return DIAG_FLASH_ValidateCRC(start, length, PFM_SEGMENT_TABLE_ADDR + (4 * segment));
+}
+
+//Called once per tick, checks the next scheduled segment
+diag_result_t PFM_Service(void)
+{
+#ifdef TEST_CHECKSUM
+    //The segment table is only generated with a valid flash checksum
+    return DIAG_PASS;
+#else
+    uint8_t segment;
+
+    if (isPriorityTurn && (nextPriority != PFM_SEGMENT_NONE))
+    {
+        segment = nextPriority;
+        nextPriority = _priorityNext(segment + 1);
+    }
+    else
+    {
+        segment = nextSegment;
+        nextSegment++;
+
+        if (nextSegment >= PFM_SEGMENT_COUNT)
+        {
+            nextSegment = 0;
+
+            passTime = TIMING_TICKS_TO_US(TIMING_ElapsedGet(passStart)) / 1000UL;
+            passStart = TIMING_TimestampGet();
+        }
+    }
+
+    isPriorityTurn = !isPriorityTurn;
+
+    if (PFM_SegmentVerify(segment) != DIAG_PASS)
+    {
+        failedSegment = segment;
+        return DIAG_FAIL;
+    }
+
+    return DIAG_PASS;
+#endif
+}
+
+//Returns the last segment that failed, or PFM_SEGMENT_NONE
+uint8_t PFM_FailedSegmentGet(void)
+{
+    return failedSegment;
+}
+
+//Returns the start address of a segment
+uint16_t PFM_SegmentAddressGet(uint8_t segment)
+{
+    return (uint16_t) (segment * PFM_SEGMENT_SIZE);
+}
+
+//Returns the time of the last full pass of the segments (ms)
+uint32_t PFM_PassTimeGet(void)
+{
+    return passTime;
+}
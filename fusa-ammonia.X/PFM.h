@@ -0,0 +1,71 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef PFM_H
+#define	PFM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+    
+//Size of a segment of the flash (bytes) - must match tools/flash_crc.py
+#define PFM_SEGMENT_SIZE 2048UL
+    
+//Number of segments, and the CRC-32 table (generated at build time) below the flash CRC
+#define PFM_SEGMENT_COUNT 32
+#define PFM_SEGMENT_TABLE_ADDR (DIAG_FLASH_CRC_STORE_ADDR - (4 * PFM_SEGMENT_COUNT))
+    
+//Segments checked every other tick, in addition to the in-order scan (bit n = segment n)
+//Segment 0 holds the vector table and the start-up code
+#define PFM_PRIORITY_SEGMENTS 0x00000001UL
+    
+//No segment
+#define PFM_SEGMENT_NONE 0xFF
+    
+    //Starts the segmented scan from the first segment
+    void PFM_Initialize(void);
+    
+    //Checks the CRC of one segment against the table
+    diag_result_t PFM_SegmentVerify(uint8_t segment);
+    
+    //Called once per tick, checks the next scheduled segment
+    diag_result_t PFM_Service(void);
+    
+    //Returns the last segment that failed, or PFM_SEGMENT_NONE
+    uint8_t PFM_FailedSegmentGet(void);
+    
+    //Returns the start address of a segment
+    uint16_t PFM_SegmentAddressGet(uint8_t segment);
+    
+    //Returns the time of the last full pass of the segments (ms)
+    uint32_t PFM_PassTimeGet(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PFM_H */
@@ -0,0 +1,99 @@
+#include "POWERFAIL.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "application.h"
+#include "fusa.h"
+#include "EEPROM.h"
+#include "HEATER.h"
+#include "PATTERN.h"
+#include "TIMING.h"
+#include "TRACE.h"
+#include "WARMUP.h"
+
+//system.h was regenerated by MCC, with the BOD_VLM_vect ISR back in system.c
+#ifndef SYSTEM_BOD_VLM_ISR_REMOVED
+#error "MCC regenerated system.c: remove its BOD_VLM_vect ISR, then add #define SYSTEM_BOD_VLM_ISR_REMOVED to system.h"
+#endif
+
+static uint32_t flushTime = 0;
+
+//Turns off the loads
+static void _loadShed(void)
+{
+    //The heater is most of the supply current
+    HEATER_Off();
+
+#ifdef FUSA_ENABLE_HW_ALARM
+    //AC1 must not sound the buzzer as the supply falls
+    ALARM_Arm(false);
+#endif
+
+    BUZZER_DISABLE();
+    PATTERN_Play(PATTERN_OFF);
+}
+
+//Turns off the analog peripherals
+static void _analogOff(void)
+{
+    AC0.CTRLA &= ~AC_ENABLE_bm;
+    AC1.CTRLA &= ~AC_ENABLE_bm;
+    ADC0.CTRLA &= ~ADC_ENABLE_bm;
+    DAC0.CTRLA &= ~DAC_ENABLE_bm;
+}
+
+//VLM interrupt, VDD is falling
+//Replaces the empty ISR generated by MCC in system.c, which must be removed after regenerating
+ISR(BOD_VLM_vect)
+{
+    BOD.INTFLAGS = BOD_VLMIF_bm;
+
+    //Not resumed, so nothing else may run
+    cli();
+
+    uint32_t start = TIMING_TimestampGet();
+
+    _loadShed();
+    EEPROM_WriteLock();
+
+    TRACE_Log(TRACE_POWER_FAIL, (uint8_t) FUSA_SystemStateGet());
+
+    //Highest priority record
+    WARMUP_EmergencyCheckpoint();
+
+    flushTime = TIMING_TICKS_TO_US(TIMING_ElapsedGet(start));
+
+    uint32_t units = flushTime / POWERFAIL_TIME_UNIT_US;
+    TRACE_Log(TRACE_POWER_FLUSH, (units > UINT8_MAX) ? UINT8_MAX : (uint8_t) units);
+
+    _analogOff();
+
+    //Only a reset wakes the device - the BOD if VDD keeps falling, the WDT if it recovers
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+
+    while (1)
+    {
+        sleep_cpu();
+    }
+}
+
+//Enables the VLM interrupt
+void POWERFAIL_Initialize(void)
+{
+    //Interrupt as VDD falls below the VLM threshold
+    BOD.INTCTRL = BOD_VLMCFG_BELOW_gc | BOD_VLMIE_bm;
+    BOD.INTFLAGS = BOD_VLMIF_bm;
+}
+
+//Returns the duration of the last flush (us), 0 if none
+uint32_t POWERFAIL_FlushTimeGet(void)
+{
+    return flushTime;
+}
@@ -0,0 +1,71 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef POWERFAIL_H
+#define	POWERFAIL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+/* Power-fail handling
+ * 
+ * The BOD Voltage Level Monitor (VLM) interrupts when VDD falls below the VLM threshold,
+ * 15% above the BOD level. The interrupt does not return:
+ * 1. Sheds the load - heater, buzzer and LED off
+ * 2. Stops new EEPROM writes (a write in progress completes)
+ * 3. Flushes the highest priority record - the warm-up progress, if it changed
+ * 4. Turns off the analog peripherals, and sleeps in power-down with interrupts disabled
+ * 
+ * If VDD keeps falling, the BOD resets the device. If VDD recovers, the WDT resets the device.
+ * The system state at the power fail and the flush time are added to the trace,
+ * which is printed after the WDT reset.
+ * 
+ * Budget:
+ * The flush is at most one warm-up record (WARMUP_RECORD_SIZE EEPROM bytes), plus waiting for
+ * a write already in progress. The hold-up capacitance must keep VDD above the BOD level for it:
+ *   C >= I * t / (V_VLM - V_BOD), with V_VLM - V_BOD = 0.15 * V_BOD
+ * With the heater off, I is the MCU and EEPROM write current.
+ * The time t is measured, and stored in the trace (TRACE_POWER_FLUSH, in POWERFAIL_TIME_UNIT_US).
+ * For example, t = 20ms at I = 5mA with a 2.7V BOD level needs C >= 250uF.
+ * 
+ * The VLM vector is handled here, MCC generates an ISR for it in system.c that has been removed.
+ * After regenerating with MCC, POWERFAIL.c stops the build with #error until the ISR is removed again,
+ * and SYSTEM_BOD_VLM_ISR_REMOVED is defined in system.h to mark the edit.
+ */
+    
+//Unit of the flush time in the trace (us)
+#define POWERFAIL_TIME_UNIT_US 100
+    
+    //Enables the VLM interrupt
+    void POWERFAIL_Initialize(void);
+    
+    //Returns the duration of the last flush (us), 0 if none
+    uint32_t POWERFAIL_FlushTimeGet(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* POWERFAIL_H */
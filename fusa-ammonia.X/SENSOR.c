@@ -7,35 +7,64 @@
 #include "mcc_generated_files/system/system.h"
 #include "mcc_generated_files/timer/delay.h"
 #include "EEPROM.h"
+#include "TIMING.h"
+#include "ENV.h"
+#include "CURVE.h"
+#include "LOG.h"
 #include "application.h"
 #include "mcc_generated_files/diagnostics/diag_library/memory/non_volatile/diag_eeprom_crc16.h"
 
-typedef enum {
-    GAS_SENSOR_INVALID = 0, GAS_SENSOR_LOW, GAS_SENSOR_HIGH
-} gas_sensor_threshold_t;
+//Hardware description of each sensor channel
+static const sensor_channel_config_t channelConfig[SENSOR_CHANNEL_COUNT] = {
+    //AN1 (sensor) is on PD4 (AIN4, AINP2), DAC0 is on PD6 (AINP3)
+    {ADC_MUXPOS_AIN4_gc, &AC1, AC_MUXPOS_AINP2_gc, AC_MUXPOS_AINP3_gc, EEPROM_REF_VALUE_ADDR(0)},
 
-static float R_S0 = 0.0;
+    /* Example of a second gas head, on AC0
+     * The sensor and comparator pins must be allocated for the board used
+     * {ADC_MUXPOS_AIN5_gc, &AC0, AC_MUXPOS_AINP1_gc, AC_MUXPOS_AINP3_gc, EEPROM_REF_VALUE_ADDR(1)},
+     */
+};
+
+#if (SENSOR_CHANNEL_COUNT > EEPROM_MAX_CHANNELS)
+#error SENSOR_CHANNEL_COUNT exceeds the channels reserved in the EEPROM map
+#endif
+
+static sensor_channel_state_t channelState[SENSOR_CHANNEL_COUNT];
 static bool memValid = false;
 
-static gas_sensor_threshold_t sensorThreshold = GAS_SENSOR_INVALID;
-static uint8_t alarmHighVal, alarmLowVal;
-static volatile uint8_t alarmValidate = 0x00;
+//Hours since the tracked baselines were last written to EEPROM
+static uint8_t baselineHours = 0;
+
+//Temperature / humidity correction at calibration (Q10)
+static uint16_t calFactor = ENV_FACTOR_ONE;
+
+//Correction of R_S0 for the current environment, relative to calibration (Q10)
+static uint16_t envFactor = ENV_FACTOR_ONE;
 
-void _initParameters(uint16_t ref)
+//Computes the DACREF setpoints of a channel from R_S0 and the environment correction
+static void _setpointsCompute(uint8_t channel)
 {
-    //Pre-calculate ADC constant for R_L
-    //V_S / V_REF * 2^n (n = ADC Resolution)
-    const float K = (SENSOR_BIAS_VOLTAGE / ADC_VREF) * ADC_BITS;
-    
+    sensor_channel_state_t* state = &channelState[channel];
+
     //Sensor resistance at 0 ppm (computed from DS)
     const float R_L = LOAD_RESISTANCE;
     
-    //Sensor Resistance
-    R_S0 = R_L * ((K / ref) - 1);
+    //R_S0 at the current temperature and humidity
+    float R_0 = (state->R_S0 * envFactor) / ENV_FACTOR_ONE;
+    
+    //Alarm ratios (R_S / R_0)
+    float ratioHigh = ALARM_THRESHOLD_HIGH;
+    float ratioLow = ALARM_THRESHOLD_LOW;
+    
+    if (CURVE_IsCalibrated(channel))
+    {
+        ratioHigh = ((float) CURVE_RatioGet(channel, ALARM_PPM_HIGH)) / CURVE_RATIO_ONE;
+        ratioLow = ((float) CURVE_RatioGet(channel, ALARM_PPM_LOW)) / CURVE_RATIO_ONE;
+    }
         
     //Alarm trigger voltage (DACREF)
-    float alarmValueHigh = (R_L / (R_L + (R_S0 * ALARM_THRESHOLD_HIGH))) * SENSOR_BIAS_VOLTAGE;
-    float alarmValueLow = (R_L / (R_L + (R_S0 * ALARM_THRESHOLD_LOW))) * SENSOR_BIAS_VOLTAGE;
+    float alarmValueHigh = (R_L / (R_L + (R_0 * ratioHigh))) * SENSOR_BIAS_VOLTAGE;
+    float alarmValueLow = (R_L / (R_L + (R_0 * ratioLow))) * SENSOR_BIAS_VOLTAGE;
     
     //Volts per bit resolution of DACREF
     const float DACREF_SENSITIVITY = DACREF_VREF / DACREF_BITS;
@@ -47,38 +76,195 @@ void _initParameters(uint16_t ref)
     //If bigger than the max allowed
     if (setPtHigh > UINT8_MAX)
     {
-        printf("WARNING: setPtHigh, DACREF at maximum.\r\n");
+        LOG_0(LOG_DACREF_HIGH_MAX);
         setPtHigh = 0xFF;
     }
     
     //If bigger than the max allowed
     if (setPtLow > UINT8_MAX)
     {
-        printf("WARNING: setPtLow, DACREF at maximum.\r\n");
+        LOG_0(LOG_DACREF_LOW_MAX);
         setPtLow = 0xFF;
     }
     
 #ifdef PRINT_SENSOR_INIT_DATA
-    printf("R_S0 = %f\r\n", R_S0);
-    printf("Alarm Point High = %f V (DACREF = 0x%x)\r\n", alarmValueHigh, setPtHigh);
-    printf("Alarm Point Low = %f V (DACREF = 0x%x)\r\n", alarmValueLow, setPtLow);
+    printf("CH%u: R_S0 = %f\r\n", channel, state->R_S0);
+    printf("CH%u: Alarm Point High = %f V (DACREF = 0x%x)\r\n", channel, alarmValueHigh, setPtHigh);
+    printf("CH%u: Alarm Point Low = %f V (DACREF = 0x%x)\r\n", channel, alarmValueLow, setPtLow);
 #endif
     
     //Store the DAC values
-    alarmHighVal = (uint8_t) setPtHigh;
-    alarmLowVal = (uint8_t) setPtLow;
+    state->alarmHighVal = (uint8_t) setPtHigh;
+    state->alarmLowVal = (uint8_t) setPtLow;
     
     //Variable used to verify the values have not been corrupted
-    alarmValidate = alarmHighVal ^ alarmLowVal;
+    state->alarmValidate = state->alarmHighVal ^ state->alarmLowVal;
+}
+
+void _initParameters(uint8_t channel, uint16_t ref)
+{
+    sensor_channel_state_t* state = &channelState[channel];
+
+    //Pre-calculate ADC constant for R_L
+    //V_S / V_REF * 2^n (n = ADC Resolution)
+    const float K = (SENSOR_BIAS_VOLTAGE / ADC_VREF) * ADC_BITS;
+
+    //Sensor resistance at 0 ppm (computed from DS)
+    const float R_L = LOAD_RESISTANCE;
+
+    //Sensor Resistance
+    state->R_S0 = R_L * ((K / ref) - 1);
+    
+    //Compute the DACREF values
+    _setpointsCompute(channel);
     
     //Default to the high threshold
-    SENSOR_ThresholdHighSet();
+    APP_DACREFSet(channel, state->alarmHighVal);
+    state->threshold = GAS_SENSOR_HIGH;
+}
+
+//Returns the correction of R_S0 for the current environment, relative to calibration (Q10)
+static uint16_t _envFactorCompute(void)
+{
+    uint32_t factor = ((uint32_t) ENV_CompensationGet()) * ENV_FACTOR_ONE;
+    return (uint16_t) ((factor + (calFactor / 2)) / calFactor);
+}
+
+//Converts a measurement to the value expected at the calibration temperature / humidity
+static uint16_t _environmentNormalize(uint16_t measurement)
+{
+    if ((envFactor == ENV_FACTOR_ONE) || (measurement == 0))
+    {
+        return measurement;
+    }
+    
+    const float K = (SENSOR_BIAS_VOLTAGE / ADC_VREF) * ADC_BITS;
+    const float R_L = LOAD_RESISTANCE;
+    
+    //Sensor resistance, scaled back to the calibration environment
+    float R_S = R_L * ((K / measurement) - 1);
+    R_S = (R_S * ENV_FACTOR_ONE) / envFactor;
+    
+    return (uint16_t) round(K / (1 + (R_S / R_L)));
+}
+
+//Returns the ratio R_S / R_0 of a measurement (Q12), corrected for temperature / humidity
+static uint16_t _ratioCompute(uint8_t channel, uint16_t measurement)
+{
+    const float precalc = (ADC_BITS * SENSOR_BIAS_VOLTAGE) / ADC_VREF;
+
+    //Sensor Resistance
+    float R_S = ((precalc / measurement) - 1) * LOAD_RESISTANCE;
+#ifdef PRINT_SENSOR_PARAMETERS
+    printf("Sensor Resistance = %f\r\n", R_S);
+#endif
+
+    //Compute ratio against R0, corrected for temperature / humidity
+    float ratio = (R_S * ENV_FACTOR_ONE) / (channelState[channel].R_S0 * envFactor);
+#ifdef PRINT_SENSOR_PARAMETERS
+    printf("Sensor Ratio (R_S / R_0) = %f\r\n\r\n", ratio);
+#endif
+
+    //Convert to Q12
+    ratio *= CURVE_RATIO_ONE;
+    if (ratio >= UINT16_MAX)
+    {
+        return UINT16_MAX;
+    }
+    else if (ratio <= 0)
+    {
+        return 0;
+    }
+    
+    return (uint16_t) round(ratio);
+}
+
+//Writes the EEPROM checksum over the current contents
+static bool _EEPROMChecksumWrite(void)
+{
+#ifdef FUSA_ENABLE_EEPROM_SIMPLE_CHECKSUM
+    //Write 0x0000 as a placeholder, then the real checksum
+    if (!EEPROM_WordWrite(EEPROM_CKSM_H_ADDR, 0x0000))
+        return false;
+    
+    if (!EEPROM_WordWrite(EEPROM_CKSM_H_ADDR, EEPROM_ChecksumCalculate()))
+        return false;
+#else
+    //Write the real CRC checksum
+    if (DIAG_EEPROM_CalculateStoreCRC(DIAG_EEPROM_START_ADDR, DIAG_EEPROM_LENGTH,
+            DIAG_EEPROM_CRC_STORE_ADDR) != DIAG_PASS)
+        return false;
+
+    LOG_1(LOG_EEPROM_CRC, EEPROM_WordRead(EEPROM_CKSM_H_ADDR));
+
+    if (DIAG_EEPROM_ValidateCRC(DIAG_EEPROM_START_ADDR, DIAG_EEPROM_LENGTH,
+            DIAG_EEPROM_CRC_STORE_ADDR) != DIAG_PASS)
+        return false;
+
+    LOG_0(LOG_EEPROM_VERIFIED);
+#endif
+    
+    return true;
+}
+
+//Sets the calibrated zero-point and tracked baseline of a channel
+static void _baselineInit(uint8_t channel, uint16_t calRef, uint16_t baseline)
+{
+    sensor_channel_state_t* state = &channelState[channel];
+    uint16_t limit = calRef >> BASELINE_DRIFT_LIMIT_SHIFT;
+    
+    //No baseline stored, or outside of the allowed drift
+    if ((baseline == 0xFFFF) || (baseline > (calRef + limit)) || (baseline < (calRef - limit)))
+    {
+        baseline = calRef;
+    }
+    
+    state->calRef = calRef;
+    state->baseline = baseline;
+    state->dayBaseline = baseline;
+    state->prevSample = baseline;
+    state->baselineFilter = ((uint32_t) baseline) << 16;
+    
+    //Compute R_L and DACREF from the tracked baseline
+    _initParameters(channel, baseline);
+}
+
+//Returns the hardware description of a channel
+const sensor_channel_config_t* SENSOR_ChannelConfigGet(uint8_t channel)
+{
+    return &channelConfig[channel];
+}
+
+//Prints the worst-case service time and memory used by each channel
+void SENSOR_ChannelStatsPrint(void)
+{
+    printf("Channel memory: %u bytes RAM, %u bytes flash\r\n",
+            sizeof(sensor_channel_state_t), sizeof(sensor_channel_config_t));
+
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        printf("CH%u: sample = %lu us, convert = %lu us\r\n", ch,
+                TIMING_TICKS_TO_US(channelState[ch].sampleTicks),
+                TIMING_TICKS_TO_US(channelState[ch].convertTicks));
+    }
 }
 
 //Initialize the constants and parameters for the sensor
 void SENSOR_EEPROMInit(void)
 {
-    _initParameters(SENSOR_ReferenceValueGet());
+    //Environment at calibration
+    calFactor = EEPROM_WordRead(EEPROM_ENV_CAL_ADDR);
+    if ((calFactor == 0xFFFF) || (calFactor == 0))
+    {
+        calFactor = ENV_FACTOR_ONE;
+    }
+    envFactor = _envFactorCompute();
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        CURVE_Load(ch);
+        _baselineInit(ch, SENSOR_ReferenceValueGet(ch), EEPROM_WordRead(EEPROM_BASELINE_ADDR(ch)));
+    }
     memValid = true;
 }
 
@@ -86,23 +272,36 @@ void SENSOR_EEPROMInit(void)
 void SENSOR_EEPROMErase(void)
 {
     EEPROM_WordWrite(EEPROM_CKSM_H_ADDR, 0xFFFF);
-    EEPROM_WordWrite(EEPROM_REF_VALUE_H_ADDR, 0xFFFF);
+    EEPROM_WordWrite(EEPROM_ENV_CAL_ADDR, 0xFFFF);
+
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        EEPROM_WordWrite(channelConfig[ch].refAddr, 0xFFFF);
+        EEPROM_WordWrite(EEPROM_BASELINE_ADDR(ch), 0xFFFF);
+        CURVE_Erase(ch);
+    }
 }
 
-//Sets the sensor to the low range
+//Sets all channels to the low range
 void SENSOR_ThresholdLowSet(void)
 {
-    //Set the new DACREF
-    APP_DACREFSet(alarmLowVal);
-    sensorThreshold = GAS_SENSOR_LOW;
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        //Set the new DACREF
+        APP_DACREFSet(ch, channelState[ch].alarmLowVal);
+        channelState[ch].threshold = GAS_SENSOR_LOW;
+    }
 }
     
-//Sets the sensor to the high range
+//Sets all channels to the high range
 void SENSOR_ThresholdHighSet(void)
 {
-    //Set the new DACREF
-    APP_DACREFSet(alarmHighVal);
-    sensorThreshold = GAS_SENSOR_HIGH;
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        //Set the new DACREF
+        APP_DACREFSet(ch, channelState[ch].alarmHighVal);
+        channelState[ch].threshold = GAS_SENSOR_HIGH;
+    }
 }
 
 //Returns true if the EEPROM is valid
@@ -111,8 +310,8 @@ bool SENSOR_IsEEPROMValid(void)
     return memValid;
 }
 
-//Write the reference value to EEPROM
-bool SENSOR_EEPROMWrite(uint16_t refValue)
+//Write the reference values of all channels to EEPROM
+bool SENSOR_EEPROMWrite(const uint16_t* refValues)
 {
     //Invalidate memory valid flag
     memValid = false;
@@ -121,45 +320,49 @@ bool SENSOR_EEPROMWrite(uint16_t refValue)
     if (!EEPROM_WordWrite(EEPROM_CKSM_H_ADDR, 0x0000))
         return false;
     
+    //Gas curves from an older EEPROM mapping are not valid
+    if (EEPROM_ByteRead(EEPROM_VERSION_ADDR) != EEPROM_VERSION_ID)
+    {
+        for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+        {
+            if (!CURVE_Erase(ch))
+                return false;
+        }
+    }
+
     //Write Version ID
     if (!EEPROM_ByteWrite(EEPROM_VERSION_ADDR, EEPROM_VERSION_ID))
         return false;
     
-    //Write the Reference Value
-    if (!EEPROM_WordWrite(EEPROM_REF_VALUE_H_ADDR, refValue))
-        return false;
-    
-#ifdef FUSA_ENABLE_EEPROM_SIMPLE_CHECKSUM
-    //Write the real checksum
-    if (!EEPROM_WordWrite(EEPROM_CKSM_H_ADDR, EEPROM_ChecksumCalculate()))
-        return false;
-#else
-    //Write the real CRC checksum
-    if (DIAG_EEPROM_CalculateStoreCRC(DIAG_EEPROM_START_ADDR, DIAG_EEPROM_LENGTH,
-            DIAG_EEPROM_CRC_STORE_ADDR) != DIAG_PASS)
+    //Write the environment at calibration
+    if (!EEPROM_WordWrite(EEPROM_ENV_CAL_ADDR, calFactor))
         return false;
+
+    //Write the Reference Values, and restart baseline tracking from them
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        if (!EEPROM_WordWrite(channelConfig[ch].refAddr, refValues[ch]))
+            return false;
+        
+        if (!EEPROM_WordWrite(EEPROM_BASELINE_ADDR(ch), 0xFFFF))
+            return false;
+    }
     
-    printf("CRC Checksum = 0x%x\r\n", EEPROM_WordRead(EEPROM_CKSM_H_ADDR));
-    
-    if (DIAG_EEPROM_ValidateCRC(DIAG_EEPROM_START_ADDR, DIAG_EEPROM_LENGTH,
-            DIAG_EEPROM_CRC_STORE_ADDR) != DIAG_PASS)
+    //Write the checksum
+    if (!_EEPROMChecksumWrite())
         return false;
     
-    printf("EEPROM Verified\r\n");
-    
-#endif
-    
     //Set the memory valid flag
     memValid = true;
     
     return true;
 }
 
-//Returns the state of the AC
-bool SENSOR_IsTripped(void)
+//Returns the state of the AC for a channel
+bool SENSOR_IsTripped(uint8_t channel)
 {
     //Above max allowable level
-    if (AC1_Read() == GAS_SENSOR_LOGIC_TRIPPED)
+    if (((channelConfig[channel].ac->STATUS & AC_CMPSTATE_bm) != 0) == GAS_SENSOR_LOGIC_TRIPPED)
     {
         return true;
     }
@@ -167,78 +370,355 @@ bool SENSOR_IsTripped(void)
     return false;
 }
 
-//This function uses the current sensor output as a reference zero, write it to memory, and sets the AC
+//Returns true if the AC of any channel is tripped
+bool SENSOR_IsAnyTripped(void)
+{
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        if (SENSOR_IsTripped(ch))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//This function uses the current sensor outputs as reference zeros, write them to memory, and sets the ACs
 bool SENSOR_Calibrate(void)
 {
-    //Get the current value
-    uint16_t result = SENSOR_SampleSensor();
+    uint16_t results[SENSOR_CHANNEL_COUNT];
+    
+    //Record the temperature / humidity at calibration
+    ENV_Measure();
+    calFactor = ENV_CompensationGet();
+    envFactor = ENV_FACTOR_ONE;
+
+    //Get the current values
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        results[ch] = SENSOR_SampleSensor(ch);
+    }
 
     //Write data to EEPROM
-    if (!SENSOR_EEPROMWrite(result))
+    if (!SENSOR_EEPROMWrite(results))
     {
-        printf("An error occurred when writing EEPROM.\r\n");
+        LOG_0(LOG_EEPROM_WRITE_ERROR);
         return false;
     }
         
     //Compute R_L and DACREF
-    _initParameters(result);
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        CURVE_Load(ch);
+        _baselineInit(ch, results[ch], results[ch]);
+    }
+    
+    //Restart the daily baseline period
+    baselineHours = 0;
         
     //Success!    
     return true;
 }
 
-//Verifies the DACREF value is set correctly
+//Verifies the DACREF value of every channel is set correctly
 diag_result_t SENSOR_SetpointVerify(void)
 {
-    if (sensorThreshold == GAS_SENSOR_LOW)
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
     {
-        if (APP_DACREFGet() != alarmLowVal)
+        const sensor_channel_state_t* state = &channelState[ch];
+
+        if (state->threshold == GAS_SENSOR_LOW)
         {
-            return DIAG_FAIL;
+            if (APP_DACREFGet(ch) != state->alarmLowVal)
+            {
+                return DIAG_FAIL;
+            }
+            else if (state->alarmValidate != (state->alarmLowVal ^ state->alarmHighVal))
+            {
+                return DIAG_FAIL;
+            }
         }
-        else if (alarmValidate != (alarmLowVal ^ alarmHighVal))
+        else if (state->threshold == GAS_SENSOR_HIGH)
         {
-            return DIAG_FAIL;
+            if (APP_DACREFGet(ch) != state->alarmHighVal)
+            {
+                return DIAG_FAIL;
+            }
+            else if (state->alarmValidate != (state->alarmLowVal ^ state->alarmHighVal))
+            {
+                return DIAG_FAIL;
+            }
         }
     }
-    else if (sensorThreshold == GAS_SENSOR_HIGH)
+    
+    return DIAG_PASS;
+}
+
+//Starts and returns the analog value of a gas sensor channel
+uint16_t SENSOR_SampleSensor(uint8_t channel)
+{
+    uint32_t start = TIMING_TimestampGet();
+
+    uint16_t result = ADC0_GetConversion(channelConfig[channel].adcMux);
+
+    //Track the worst-case sample time
+    uint16_t ticks = (uint16_t) TIMING_ElapsedGet(start);
+    if (ticks > channelState[channel].sampleTicks)
+    {
+        channelState[channel].sampleTicks = ticks;
+    }
+
+    return result;
+}
+
+//Returns the stored reference value of a channel
+uint16_t SENSOR_ReferenceValueGet(uint8_t channel)
+{
+    return EEPROM_WordRead(channelConfig[channel].refAddr);
+}
+
+//Updates the drift compensated baseline of a channel with a clean-air sample
+void SENSOR_BaselineTrack(uint8_t channel, uint16_t measurement)
+{
+    /* A leak must never be absorbed into the baseline:
+     * 1. Only samples within BASELINE_CLEAN_AIR_BAND of the baseline are used
+     * 2. The air must be stable (no rising or falling concentration)
+     * 3. A tripped channel is never updated
+     * 4. The baseline moves at most BASELINE_DAILY_STEP_LIMIT per day
+     * 5. The baseline stays within 1/2^BASELINE_DRIFT_LIMIT_SHIFT of the calibration
+     */
+    
+    sensor_channel_state_t* state = &channelState[channel];
+    
+    if (!memValid)
+    {
+        return;
+    }
+    
+    //Remove the temperature / humidity dependency, so it is not tracked as drift
+    measurement = _environmentNormalize(measurement);
+    
+    //Is the air stable?
+    uint16_t delta = (measurement > state->prevSample) ? 
+        (measurement - state->prevSample) : (state->prevSample - measurement);
+    state->prevSample = measurement;
+    
+    if (delta > BASELINE_STABLE_BAND)
+    {
+        return;
+    }
+    
+    //Is the air clean?
+    if ((measurement > (state->baseline + BASELINE_CLEAN_AIR_BAND)) ||
+            ((measurement + BASELINE_CLEAN_AIR_BAND) < state->baseline) ||
+            SENSOR_IsTripped(channel))
+    {
+        return;
+    }
+    
+    //Single pole IIR filter, 16.16 fixed point
+    int32_t error = (int32_t) ((((uint32_t) measurement) << 16) - state->baselineFilter);
+    state->baselineFilter += error >> BASELINE_FILTER_SHIFT;
+    
+    //Rounded filter output
+    uint16_t candidate = (uint16_t) ((state->baselineFilter + 0x8000UL) >> 16);
+    
+    //Limit the change per day
+    if (candidate > (state->dayBaseline + BASELINE_DAILY_STEP_LIMIT))
+    {
+        candidate = state->dayBaseline + BASELINE_DAILY_STEP_LIMIT;
+    }
+    else if ((candidate + BASELINE_DAILY_STEP_LIMIT) < state->dayBaseline)
     {
-        if (APP_DACREFGet() != alarmHighVal)
+        candidate = state->dayBaseline - BASELINE_DAILY_STEP_LIMIT;
+    }
+    
+    //Limit the total drift from calibration
+    uint16_t limit = state->calRef >> BASELINE_DRIFT_LIMIT_SHIFT;
+    if (candidate > (state->calRef + limit))
+    {
+        candidate = state->calRef + limit;
+    }
+    else if (candidate < (state->calRef - limit))
+    {
+        candidate = state->calRef - limit;
+    }
+    
+    if (candidate != state->baseline)
+    {
+        state->baseline = candidate;
+        
+        //Recompute R_S0 and DACREF from the new baseline
+        _initParameters(channel, candidate);
+        
+        if ((candidate == (state->calRef + limit)) || (candidate == (state->calRef - limit)))
         {
-            return DIAG_FAIL;
+            LOG_1(LOG_BASELINE_LIMIT, channel);
         }
-        else if (alarmValidate != (alarmLowVal ^ alarmHighVal))
+    }
+}
+
+//Called once per hour, writes the tracked baselines to EEPROM once per day
+void SENSOR_BaselineHourTick(void)
+{
+    baselineHours++;
+    
+    if (baselineHours < BASELINE_PERSIST_HOURS)
+    {
+        return;
+    }
+    
+    baselineHours = 0;
+    
+    if (!memValid)
+    {
+        return;
+    }
+    
+    bool isChanged = false;
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        sensor_channel_state_t* state = &channelState[ch];
+        
+        //Start a new daily step window
+        state->dayBaseline = state->baseline;
+        
+        if (EEPROM_WordRead(EEPROM_BASELINE_ADDR(ch)) != state->baseline)
         {
-            return DIAG_FAIL;
+            if (!EEPROM_WordWrite(EEPROM_BASELINE_ADDR(ch), state->baseline))
+            {
+                memValid = false;
+                return;
+            }
+            isChanged = true;
         }
     }
     
-    return DIAG_PASS;
+    if (isChanged)
+    {
+        LOG_0(LOG_BASELINE_UPDATED);
+        
+        if (!_EEPROMChecksumWrite())
+        {
+            memValid = false;
+        }
+    }
+}
+
+//Applies the latest temperature / humidity correction to every channel
+void SENSOR_EnvironmentUpdate(void)
+{
+    if (!memValid)
+    {
+        return;
+    }
+    
+    uint16_t factor = _envFactorCompute();
+    
+    //Ignore small changes
+    if (((factor > envFactor) ? (factor - envFactor) : (envFactor - factor)) < ENV_COMP_HYSTERESIS)
+    {
+        return;
+    }
+    
+    envFactor = factor;
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        sensor_channel_state_t* state = &channelState[ch];
+        
+        //Recompute the setpoints, and keep the active threshold
+        _setpointsCompute(ch);
+        APP_DACREFSet(ch, (state->threshold == GAS_SENSOR_LOW) ? state->alarmLowVal : state->alarmHighVal);
+    }
 }
 
-//Starts and returns the analog value of the gas sensor
-uint16_t SENSOR_SampleSensor(void)
+//Starts a multi-point calibration of the gas response curve
+void SENSOR_CurveCaptureStart(void)
 {
-    //PD4, AIN4
-    return ADC0_GetConversion(ADC_MUXPOS_AIN4_gc);
+    CURVE_CaptureStart();
 }
 
-//Returns the stored reference value
-uint16_t SENSOR_ReferenceValueGet(void)
+//Samples every channel in a reference gas of known concentration
+bool SENSOR_CurvePointCapture(uint16_t ppm)
 {
-    return EEPROM_WordRead(EEPROM_REF_VALUE_H_ADDR);
+    uint16_t ratios[SENSOR_CHANNEL_COUNT];
+    
+    //The zero-point must be calibrated first
+    if (!memValid)
+    {
+        return false;
+    }
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        uint16_t measurement = SENSOR_SampleSensor(ch);
+        
+        if ((measurement == 0) || (channelState[ch].R_S0 <= 0))
+        {
+            return false;
+        }
+        
+        ratios[ch] = _ratioCompute(ch, measurement);
+        LOG_3(LOG_CURVE_POINT, ch, ppm, ratios[ch]);
+    }
+    
+    return CURVE_PointCapture(ppm, ratios);
 }
 
-//Converts a measurement value into PPM
-uint16_t SENSOR_MeasurementConvert(uint16_t measurement)
+//Fits the captured points, stores the curves and updates the alarm setpoints
+bool SENSOR_CurveFit(void)
 {
+    if (!memValid)
+    {
+        return false;
+    }
+    
+    //Fit the points, nothing is written if this fails
+    if (!CURVE_Fit())
+    {
+        return false;
+    }
+    
+    //Invalidate memory valid flag
+    memValid = false;
+    
+    if (!CURVE_Write())
+        return false;
+    
+    //Write the checksum
+    if (!_EEPROMChecksumWrite())
+        return false;
+    
+    memValid = true;
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        sensor_channel_state_t* state = &channelState[ch];
+        
+        //Rebuild the lookup table, and the setpoints from it
+        CURVE_Load(ch);
+        _setpointsCompute(ch);
+        APP_DACREFSet(ch, (state->threshold == GAS_SENSOR_LOW) ? state->alarmLowVal : state->alarmHighVal);
+    }
+    
+    return true;
+}
+
+//Converts a measurement value of a channel into PPM
+uint16_t SENSOR_MeasurementConvert(uint8_t channel, uint16_t measurement)
+{
+    sensor_channel_state_t* state = &channelState[channel];
+
     //Check for bad conditions
     if (measurement == 0)
     {
         //If the measurement is 0, return max PPM
         return UINT16_MAX;
     }
-    else if (R_S0 <= 0)
+    else if (state->R_S0 <= 0)
     {
         //If the load resistance is not set (error state), return max PPM
         return UINT16_MAX;
@@ -249,23 +729,17 @@ uint16_t SENSOR_MeasurementConvert(uint16_t measurement)
         return UINT16_MAX;
     }
     
-    const float precalc = (ADC_BITS * SENSOR_BIAS_VOLTAGE) / ADC_VREF;
-    
-    //Sensor Resistance
-    float R_S = ((precalc / measurement) - 1) * LOAD_RESISTANCE;
-#ifdef PRINT_SENSOR_PARAMETERS
-    printf("Sensor Resistance = %f\r\n", R_S);
-#endif
+    uint32_t start = TIMING_TimestampGet();
 
-    //Compute ratio against R0
-    float ratio = R_S / R_S0;
-#ifdef PRINT_SENSOR_PARAMETERS
-    printf("Sensor Ratio (R_S / R_0) = %f\r\n\r\n", ratio);
-#endif
-    
-    //Constants are from a best-fit plot of the provided sensor data
-    //PPM = 0.1282 * result^(-3.833)
-    uint16_t result = round(0.1282 * powf(ratio, -3.833));
+    //Look up the PPM in the gas response curve
+    uint16_t result = CURVE_PPMGet(channel, _ratioCompute(channel, measurement));
     
+    //Track the worst-case conversion time
+    uint32_t ticks = TIMING_ElapsedGet(start);
+    if (ticks > state->convertTicks)
+    {
+        state->convertTicks = ticks;
+    }
+
     return result;
 }
@@ -29,6 +29,8 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <avr/io.h>
+
 #include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
     
 //Prints the measured sensor parameters
@@ -37,6 +39,37 @@ extern "C" {
 //Prints the sensor constants
 //#define PRINT_SENSOR_INIT_DATA
     
+//Prints the worst-case service time and memory used by each channel
+//#define PRINT_CHANNEL_STATS
+    
+//Number of gas sensor channels serviced each tick
+//Each channel must have an entry in the channel table in SENSOR.c
+#define SENSOR_CHANNEL_COUNT 1
+    
+//Time constant of the baseline filter, as a power of 2 ticks
+//2^14 ticks at 0.5s is ~2.3 hours
+#define BASELINE_FILTER_SHIFT 14
+    
+//Max ADC counts from the baseline for a sample to be considered clean air
+#define BASELINE_CLEAN_AIR_BAND 8
+    
+//Max ADC counts between consecutive samples for the air to be considered stable
+#define BASELINE_STABLE_BAND 4
+    
+//Max ADC counts the baseline may move per day
+#define BASELINE_DAILY_STEP_LIMIT 16
+    
+//Max drift from the calibrated zero-point, as a right shift of the zero-point
+//3 = 1/8 (12.5%) of the calibrated value
+#define BASELINE_DRIFT_LIMIT_SHIFT 3
+    
+//Hours between writes of the tracked baseline to EEPROM
+#define BASELINE_PERSIST_HOURS 24
+    
+//Min change of the temperature / humidity correction (Q10) before the setpoints are recomputed
+//8 / 1024 = 0.8%
+#define ENV_COMP_HYSTERESIS 8
+    
 //This is the alarm HIGH threshold
 //Set to the 50 ppm point on the MQ-137 response curve
 #define ALARM_THRESHOLD_HIGH 0.205
@@ -45,6 +78,11 @@ extern "C" {
 //Set to the 30 ppm point on the MQ-137 response curve
 #define ALARM_THRESHOLD_LOW 0.240
     
+//Alarm thresholds (ppm) used with a multi-point calibrated gas curve
+//ALARM_THRESHOLD_HIGH / LOW are used with the default curve
+#define ALARM_PPM_HIGH 50
+#define ALARM_PPM_LOW 30
+    
 //This is the load resistance
 #define LOAD_RESISTANCE 100.0
     
@@ -66,41 +104,97 @@ extern "C" {
 #define GAS_SENSOR_LOGIC_TRIPPED false
 #define GAS_SENSOR_LOGIC_NOT_TRIPPED true
     
+    typedef enum {
+        GAS_SENSOR_INVALID = 0, GAS_SENSOR_LOW, GAS_SENSOR_HIGH
+    } gas_sensor_threshold_t;
+    
+    //Hardware resources used by a sensor channel
+    typedef struct {
+        ADC_MUXPOS_t adcMux;        //ADC0 input connected to the sensor
+        AC_t* ac;                   //Comparator used for the alarm threshold
+        AC_MUXPOS_t acSensorMux;    //Comparator input connected to the sensor
+        AC_MUXPOS_t acDACMux;       //Comparator input connected to DAC0
+        uint16_t refAddr;           //EEPROM address of the reference value
+    } sensor_channel_config_t;
+    
+    //Runtime state of a sensor channel
+    typedef struct {
+        float R_S0;                         //Sensor resistance at 0 ppm
+        gas_sensor_threshold_t threshold;   //Active alarm threshold
+        uint8_t alarmHighVal;               //DACREF for the HIGH threshold
+        uint8_t alarmLowVal;                //DACREF for the LOW threshold
+        uint8_t alarmValidate;              //alarmHighVal ^ alarmLowVal
+        uint16_t calRef;                    //Calibrated zero-point (ADC)
+        uint16_t baseline;                  //Tracked zero-point (ADC)
+        uint16_t dayBaseline;               //Tracked zero-point at the start of the day
+        uint16_t prevSample;                //Previous sample, for stability detection
+        uint32_t baselineFilter;            //Baseline filter, 16.16 fixed point
+        uint16_t sampleTicks;               //Worst-case sample time
+        uint32_t convertTicks;              //Worst-case conversion time
+    } sensor_channel_state_t;
+    
+    //Returns the hardware description of a channel
+    const sensor_channel_config_t* SENSOR_ChannelConfigGet(uint8_t channel);
+    
+    //Prints the worst-case service time and memory used by each channel
+    void SENSOR_ChannelStatsPrint(void);
+    
     //Initialize the constants and parameters for the sensor
     void SENSOR_EEPROMInit(void);
     
     //Erases the EEPROM
     void SENSOR_EEPROMErase(void);
     
-    //Sets the sensor to the low range
+    //Sets all channels to the low range
     void SENSOR_ThresholdLowSet(void);
     
-    //Sets the sensor to the high range
+    //Sets all channels to the high range
     void SENSOR_ThresholdHighSet(void);
     
     //Returns true if the EEPROM is valid
     bool SENSOR_IsEEPROMValid(void);
     
-    //Write the reference value to EEPROM
-    bool SENSOR_EEPROMWrite(uint16_t refValue);
+    //Write the reference values of all channels to EEPROM
+    bool SENSOR_EEPROMWrite(const uint16_t* refValues);
+    
+    //Returns the state of the AC for a channel
+    bool SENSOR_IsTripped(uint8_t channel);
     
-    //Returns the state of the AC
-    bool SENSOR_IsTripped(void);
+    //Returns true if the AC of any channel is tripped
+    bool SENSOR_IsAnyTripped(void);
     
-    //This function uses the current sensor output as a reference zero, write it to memory, and sets the AC
+    //This function uses the current sensor outputs as reference zeros, write them to memory, and sets the ACs
     bool SENSOR_Calibrate(void);
     
-    //Verifies the DACREF value is set correctly
+    //Verifies the DACREF value of every channel is set correctly
     diag_result_t SENSOR_SetpointVerify(void);
         
-    //Starts and returns the analog value of the gas sensor
-    uint16_t SENSOR_SampleSensor(void);
+    //Starts and returns the analog value of a gas sensor channel
+    uint16_t SENSOR_SampleSensor(uint8_t channel);
+    
+    //Returns the stored reference value of a channel
+    uint16_t SENSOR_ReferenceValueGet(uint8_t channel);
+    
+    //Updates the drift compensated baseline of a channel with a clean-air sample
+    void SENSOR_BaselineTrack(uint8_t channel, uint16_t measurement);
+    
+    //Called once per hour, writes the tracked baselines to EEPROM once per day
+    void SENSOR_BaselineHourTick(void);
+    
+    //Applies the latest temperature / humidity correction to every channel
+    void SENSOR_EnvironmentUpdate(void);
+    
+    //Starts a multi-point calibration of the gas response curve
+    void SENSOR_CurveCaptureStart(void);
+    
+    //Samples every channel in a reference gas of known concentration
+    bool SENSOR_CurvePointCapture(uint16_t ppm);
     
-    //Returns the stored reference value
-    uint16_t SENSOR_ReferenceValueGet(void);
+    //Fits the captured points, stores the curves and updates the alarm setpoints
+    bool SENSOR_CurveFit(void);
     
-    //Converts a measurement value into PPM
-    uint16_t SENSOR_MeasurementConvert(uint16_t measurement);
+    //Converts a measurement value of a channel into PPM
+    uint16_t SENSOR_MeasurementConvert(uint8_t channel, uint16_t measurement);
 
 #ifdef	__cplusplus
 }
@@ -0,0 +1,102 @@
+#include "STACK.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+
+//From the linker - the stack grows down from __stack towards the end of the variables
+extern uint8_t __heap_start;
+extern uint8_t __stack;
+
+#define STACK_BOTTOM (&__heap_start)
+#define STACK_TOP (&__stack)
+
+//Lowest address written by the stack, and its complement for verification
+static uint8_t* watermark;
+static uint16_t watermarkCheck;
+
+//Next address checked by the high-water scan
+static uint8_t* scanAddr;
+
+//Paints the stack region, after the start-up March test (.init0) and before the variables are initialized
+//Naked - nothing may be pushed to the stack that is being painted
+static void __attribute__((used, naked, section(".init3"))) _stackPaint(void)
+{
+    register uint8_t* addr = STACK_BOTTOM;
+
+    while (addr < (uint8_t*) SP)
+    {
+        *addr++ = STACK_PAINT;
+    }
+}
+
+//Starts the high-water scan of the stack painted at start-up
+void STACK_Initialize(void)
+{
+    //Everything above SP is in use
+    watermark = (uint8_t*) SP;
+    watermarkCheck = ~((uint16_t) watermark);
+
+    scanAddr = watermark - 1;
+}
+
+//Checks the next part of the stack region, fails if the peak usage exceeds the limit
+diag_result_t STACK_Scan(void)
+{
+    //Variable corrupted
+    if ((uint16_t) watermark != (uint16_t) (~watermarkCheck))
+    {
+        return DIAG_FAIL;
+    }
+
+    for (uint8_t i = 0; i < STACK_SCAN_BYTES; i++)
+    {
+        //Pass complete, restart below the watermark
+        if (scanAddr < STACK_BOTTOM)
+        {
+            scanAddr = watermark - 1;
+            break;
+        }
+
+        //Written since start-up - keep scanning, a deep frame may leave painted bytes above it
+        if (*scanAddr != STACK_PAINT)
+        {
+            watermark = scanAddr;
+            watermarkCheck = ~((uint16_t) watermark);
+        }
+
+        scanAddr--;
+    }
+
+    if (STACK_PeakGet() > (((uint32_t) STACK_SizeGet() * STACK_LIMIT_PCT) / 100))
+    {
+        return DIAG_FAIL;
+    }
+
+    return DIAG_PASS;
+}
+
+//Returns the peak stack usage (bytes)
+uint16_t STACK_PeakGet(void)
+{
+    return (uint16_t) (STACK_TOP - watermark) + 1;
+}
+
+//Returns the size of the stack region (bytes)
+uint16_t STACK_SizeGet(void)
+{
+    return (uint16_t) (STACK_TOP - STACK_BOTTOM) + 1;
+}
+
+//Prints the peak stack usage
+void STACK_UsagePrint(void)
+{
+    uint16_t size = STACK_SizeGet();
+    uint16_t peak = STACK_PeakGet();
+
+    printf("Stack: peak = %u / %u bytes (%u%%), limit = %u%%\r\n",
+            peak, size, (uint16_t) (((uint32_t) peak * 100) / size), STACK_LIMIT_PCT);
+}
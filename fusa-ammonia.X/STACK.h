@@ -0,0 +1,65 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef STACK_H
+#define	STACK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+    
+//Prints the peak stack usage every hour
+//#define PRINT_STACK_USAGE
+    
+//Value written to the unused stack at start-up
+#define STACK_PAINT 0xC5
+    
+//Bytes of the stack region checked per tick by the high-water scan
+#define STACK_SCAN_BYTES 128
+    
+//Peak stack usage (% of the stack region) treated as a fault
+#define STACK_LIMIT_PCT 75
+    
+    //Starts the high-water scan of the stack painted at start-up
+    void STACK_Initialize(void);
+    
+    //Checks the next part of the stack region, fails if the peak usage exceeds the limit
+    diag_result_t STACK_Scan(void);
+    
+    //Returns the peak stack usage (bytes)
+    uint16_t STACK_PeakGet(void);
+    
+    //Returns the size of the stack region (bytes)
+    uint16_t STACK_SizeGet(void);
+    
+    //Prints the peak stack usage
+    void STACK_UsagePrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* STACK_H */
@@ -0,0 +1,103 @@
+#include "TIMING.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+//Upper 16 bits of the timestamp, incremented on each wrap of TCB1
+static volatile uint16_t timingUpper = 0;
+
+//TCB1 counts scale times faster while CLK_PER is boosted
+//Timestamps are base + (count - countBase) / scale
+static uint8_t timingScale = 1;
+static uint32_t timingBase = 0;
+static uint32_t timingCountBase = 0;
+
+//Returns the 32-bit count of TCB1
+static uint32_t _countGet(void)
+{
+    uint16_t upper, lower;
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        lower = TIMING_TCB.CNT;
+
+        //A wrap is pending, but the ISR has not run yet (interrupts disabled)
+        if (TIMING_TCB.INTFLAGS & TCB_CAPT_bm)
+        {
+            //Handle the wrap here, so the ISR does not count it twice
+            TIMING_TCB.INTFLAGS = TCB_CAPT_bm;
+            timingUpper++;
+
+            //Re-read, in case the counter wrapped after the first read
+            lower = TIMING_TCB.CNT;
+        }
+
+        upper = timingUpper;
+    }
+    
+    return (((uint32_t) upper) << 16) | lower;
+}
+
+//Starts the free-running timebase
+void TIMING_Initialize(void)
+{
+    //Periodic interrupt mode, wraps at 0xFFFF
+    TIMING_TCB.CTRLB = TCB_CNTMODE_INT_gc;
+    TIMING_TCB.CCMP = 0xFFFF;
+    TIMING_TCB.CNT = 0x0000;
+    
+    //Clear any stale flag, then enable the wrap interrupt
+    TIMING_TCB.INTFLAGS = TCB_CAPT_bm;
+    TIMING_TCB.INTCTRL = TCB_CAPT_bm;
+    
+    //Start counting
+    TIMING_TCB.CTRLA = TIMING_TCB_CLKSEL | TCB_ENABLE_bm;
+}
+
+ISR(TCB1_INT_vect)
+{
+    TIMING_TCB.INTFLAGS = TCB_CAPT_bm;
+    timingUpper++;
+}
+
+//Returns the current 32-bit timestamp in ticks
+uint32_t TIMING_TimestampGet(void)
+{
+    uint32_t count;
+    uint32_t timestamp;
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        count = _countGet() - timingCountBase;
+        
+        if (timingScale != 1)
+        {
+            count /= timingScale;
+        }
+        
+        timestamp = timingBase + count;
+    }
+    
+    return timestamp;
+}
+
+//Returns the number of ticks elapsed since the timestamp
+uint32_t TIMING_ElapsedGet(uint32_t start)
+{
+    return TIMING_TimestampGet() - start;
+}
+
+//Sets CLK_PER as a multiple of F_CPU, timestamps continue without a step
+void TIMING_ScaleSet(uint8_t scale)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        timingBase = TIMING_TimestampGet();
+        timingCountBase = _countGet();
+        timingScale = (scale == 0) ? 1 : scale;
+    }
+}
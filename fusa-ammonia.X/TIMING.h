@@ -0,0 +1,63 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef TIMING_H
+#define	TIMING_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//TCB1 is used as a free-running timebase for execution time measurements
+//CLK_PER / 2 = 1.667 MHz, or 0.6 us per tick
+//Timestamps stay in these units while CPUCLK boosts CLK_PER (see TIMING_ScaleSet)
+#define TIMING_TCB TCB1
+#define TIMING_TCB_CLKSEL TCB_CLKSEL_DIV2_gc
+    
+//Converts timebase ticks to microseconds (0.6 us / tick)
+#define TIMING_TICKS_TO_US(ticks) ((((uint32_t) (ticks)) * 3UL) / 5UL)
+    
+//Converts microseconds to timebase ticks
+#define TIMING_US_TO_TICKS(us) ((((uint32_t) (us)) * 5UL) / 3UL)
+    
+    //Starts the free-running timebase
+    void TIMING_Initialize(void);
+    
+    //Returns the current 32-bit timestamp in ticks
+    //Must be called at least once every 39 ms (divided by the clock scale) if interrupts are disabled
+    uint32_t TIMING_TimestampGet(void);
+    
+    //Returns the number of ticks elapsed since the timestamp
+    uint32_t TIMING_ElapsedGet(uint32_t start);
+    
+    //Sets CLK_PER as a multiple of F_CPU, timestamps continue without a step
+    //Call with interrupts disabled, as CLK_PER changes
+    void TIMING_ScaleSet(uint8_t scale);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TIMING_H */
+
@@ -0,0 +1,162 @@
+#include "TRACE.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <xc.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "TIMING.h"
+
+//The trace is not cleared by the C start-up code, and the start-up March test
+//is skipped after a WDT reset, so the buffer survives a WDT reset
+static __persistent trace_entry_t traceBuffer[TRACE_ENTRIES];
+static __persistent uint16_t traceMagic;
+static __persistent uint8_t traceHead;
+static __persistent uint8_t traceCount;
+static __persistent uint8_t traceHeaderCRC;
+
+//Current stage, and its complement for verification
+static volatile __persistent uint8_t traceStage;
+static volatile __persistent uint8_t traceStageCheck;
+
+//CRC-8 (x^8 + x^2 + x + 1), processed a nibble at a time
+static const uint8_t crcTable[16] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+static const char* const eventNames[TRACE_EVENT_COUNT] = {
+    "Boot", "State", "Failure", "WDT withheld", "WDT deferred", "Memory scan",
+    "Power fail", "Power fail flush"
+};
+
+//Computes the CRC-8 of a block of data
+static uint8_t _crcCompute(const uint8_t* data, uint8_t length)
+{
+    uint8_t crc = 0xFF;
+
+    while (length--)
+    {
+        crc ^= *data++;
+        crc = (uint8_t) (crc << 4) ^ crcTable[crc >> 4];
+        crc = (uint8_t) (crc << 4) ^ crcTable[crc >> 4];
+    }
+
+    return crc;
+}
+
+//Computes the CRC-8 of the trace header
+static uint8_t _headerCRCCompute(void)
+{
+    uint8_t header[4] = {(uint8_t) traceMagic, (uint8_t) (traceMagic >> 8), traceHead, traceCount};
+    return _crcCompute(header, sizeof(header));
+}
+
+//Returns true if the trace header is valid
+static bool _headerIsValid(void)
+{
+    if ((traceMagic != TRACE_MAGIC) || (traceHeaderCRC != _headerCRCCompute()))
+    {
+        return false;
+    }
+    else if ((traceHead >= TRACE_ENTRIES) || (traceCount > TRACE_ENTRIES))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//Prints the trace buffer, oldest entry first
+void TRACE_Print(void)
+{
+    printf("Trace (%u entries):\r\n", traceCount);
+
+    uint8_t index = (traceHead + TRACE_ENTRIES - traceCount) % TRACE_ENTRIES;
+
+    for (uint8_t i = 0; i < traceCount; i++)
+    {
+        const trace_entry_t* entry = &traceBuffer[index];
+
+        if ((entry->crc != _crcCompute((const uint8_t*) entry, sizeof(trace_entry_t) - 1)) ||
+                (entry->event >= TRACE_EVENT_COUNT))
+        {
+            printf("  Corrupted entry\r\n");
+        }
+        else
+        {
+            printf("  %lu ms: %s (%u), stage %u\r\n", TIMING_TICKS_TO_US(entry->time / 1000UL),
+                    eventNames[entry->event], entry->arg, entry->stage);
+        }
+
+        index = (index + 1) % TRACE_ENTRIES;
+    }
+
+    if (traceStage == (uint8_t) (~traceStageCheck))
+    {
+        printf("Last stage: %u\r\n", traceStage);
+    }
+    else
+    {
+        printf("Last stage: corrupted\r\n");
+    }
+}
+
+//Dumps the trace of the last reset (if valid), then starts a new trace
+void TRACE_Initialize(uint8_t resetFlags)
+{
+    if (_headerIsValid())
+    {
+        printf("Before reset - ");
+        TRACE_Print();
+    }
+    else if (traceMagic == TRACE_MAGIC)
+    {
+        //Only reported if a trace was started, SRAM is cleared by the start-up March test
+        printf("Trace buffer corrupted\r\n");
+    }
+
+    //Start a new trace
+    traceMagic = TRACE_MAGIC;
+    traceHead = 0;
+    traceCount = 0;
+    traceHeaderCRC = _headerCRCCompute();
+
+    TRACE_StageSet(TRACE_STAGE_STARTUP);
+    TRACE_Log(TRACE_BOOT, resetFlags);
+}
+
+//Adds an event to the trace buffer
+void TRACE_Log(trace_event_t event, uint8_t arg)
+{
+    uint32_t time = TIMING_TimestampGet();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        trace_entry_t* entry = &traceBuffer[traceHead];
+
+        entry->time = time;
+        entry->event = event;
+        entry->arg = arg;
+        entry->stage = traceStage;
+        entry->crc = _crcCompute((const uint8_t*) entry, sizeof(trace_entry_t) - 1);
+
+        //Entry is complete, update the header
+        traceHead = (traceHead + 1) % TRACE_ENTRIES;
+        if (traceCount < TRACE_ENTRIES)
+        {
+            traceCount++;
+        }
+        traceHeaderCRC = _headerCRCCompute();
+    }
+}
+
+//Sets the stage being executed
+void TRACE_StageSet(trace_stage_t stage)
+{
+    traceStage = stage;
+    traceStageCheck = ~stage;
+}
@@ -0,0 +1,88 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef TRACE_H
+#define	TRACE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Number of entries in the trace buffer (max 255)
+#define TRACE_ENTRIES 32
+    
+//Marks an initialized trace buffer
+#define TRACE_MAGIC 0x7A5C
+    
+    //Events stored in the trace buffer
+    typedef enum {
+        TRACE_BOOT = 0,         //arg = reset flags
+        TRACE_STATE,            //arg = new system state
+        TRACE_FAILURE,          //arg = system state
+        TRACE_WDT_WITHHELD,     //arg = completed diagnostics
+        TRACE_WDT_DEFERRED,     //arg = 0
+        TRACE_MEMORY_SCAN,      //arg = 0 start, 1 complete
+        TRACE_POWER_FAIL,       //arg = system state
+        TRACE_POWER_FLUSH,      //arg = flush time (POWERFAIL_TIME_UNIT_US)
+        TRACE_EVENT_COUNT
+    } trace_event_t;
+    
+    //Stage of the main loop / periodic self-check being executed
+    typedef enum {
+        TRACE_STAGE_STARTUP = 0, TRACE_STAGE_IDLE, TRACE_STAGE_SENSOR,
+        TRACE_STAGE_SRAM, TRACE_STAGE_STATE, TRACE_STAGE_SETPOINT,
+        TRACE_STAGE_HEATER, TRACE_STAGE_WDT, TRACE_STAGE_CPU,
+        TRACE_STAGE_STATE_MACHINE, TRACE_STAGE_HEATER_SERVICE, TRACE_STAGE_ENV,
+        TRACE_STAGE_MEMORY_SCAN, TRACE_STAGE_SRAM_SLACK, TRACE_STAGE_WDT_KICK,
+        TRACE_STAGE_STACK, TRACE_STAGE_CONSOLE, TRACE_STAGE_FLASH_SEGMENT,
+        TRACE_STAGE_ALARM_PATH,
+        TRACE_STAGE_AC_ADC, TRACE_STAGE_WARMUP, TRACE_STAGE_COUNT
+    } trace_stage_t;
+    
+    //One entry of the trace buffer
+    typedef struct {
+        uint32_t time;          //TIMING timestamp
+        uint8_t event;          //trace_event_t
+        uint8_t arg;
+        uint8_t stage;          //Stage when the event was logged
+        uint8_t crc;            //CRC-8 of the entry
+    } trace_entry_t;
+    
+    //Dumps the trace of the last reset (if valid), then starts a new trace
+    void TRACE_Initialize(uint8_t resetFlags);
+    
+    //Adds an event to the trace buffer
+    void TRACE_Log(trace_event_t event, uint8_t arg);
+    
+    //Sets the stage being executed
+    void TRACE_StageSet(trace_stage_t stage);
+    
+    //Prints the trace buffer, oldest entry first
+    void TRACE_Print(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TRACE_H */
@@ -0,0 +1,223 @@
+#include "WARMUP.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+#include "application.h"
+#include "EEPROM.h"
+#include "LOG.h"
+
+#if (EEPROM_WARMUP_LOG_ADDR < (DIAG_EEPROM_START_ADDR + DIAG_EEPROM_LENGTH))
+#error The warm-up log overlaps the CRC protected region of the EEPROM
+#endif
+
+//Number of records in the log
+#define WARMUP_SLOTS (EEPROM_WARMUP_LOG_SIZE / WARMUP_RECORD_SIZE)
+
+//Progress of a complete warm-up (minutes)
+#define WARMUP_FULL_MINUTES ((uint16_t) WARM_UP_HOURS * 60U)
+
+//The progress since the reset has not been written
+#define WARMUP_UNSAVED 0xFFFF
+
+static uint8_t nextSlot = 0;
+static uint8_t nextSeq = 0;
+static uint16_t savedMinutes = WARMUP_UNSAVED;
+
+//Progress from before the reset, and the estimated supply loss
+static uint16_t lastMinutes = 0;
+static uint16_t offMinutes = WARMUP_OFF_UNKNOWN;
+
+//CRC-8 (polynomial 0x07) of a record
+static uint8_t _crcCompute(const uint8_t* data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+//Reads a record, returns false if it is erased or torn
+static bool _recordRead(uint8_t slot, uint8_t* record)
+{
+    uint16_t addr = EEPROM_WARMUP_LOG_ADDR + (WARMUP_RECORD_SIZE * slot);
+
+    for (uint8_t i = 0; i < WARMUP_RECORD_SIZE; i++)
+    {
+        record[i] = EEPROM_ByteRead(addr + i);
+    }
+
+    return (_crcCompute(record, WARMUP_RECORD_SIZE - 1) == record[WARMUP_RECORD_SIZE - 1]);
+}
+
+//Returns the warm-up progress, limited to a complete warm-up (minutes)
+static uint16_t _progressGet(void)
+{
+    uint16_t minutes = APP_WarmupMinutesGet();
+    return (minutes > WARMUP_FULL_MINUTES) ? WARMUP_FULL_MINUTES : minutes;
+}
+
+//Finds the last checkpoint, and the warm-up credit for the cause of the reset
+void WARMUP_Initialize(uint8_t resetFlags)
+{
+    bool isFound = false;
+    uint8_t record[WARMUP_RECORD_SIZE];
+    uint8_t lastSeq = 0;
+
+    //Newest record - the sequence numbers in the log are within one lap of each other
+    for (uint8_t slot = 0; slot < WARMUP_SLOTS; slot++)
+    {
+        if (!_recordRead(slot, record))
+        {
+            continue;
+        }
+
+        if ((!isFound) || (((int8_t) (record[0] - lastSeq)) > 0))
+        {
+            isFound = true;
+            lastSeq = record[0];
+            lastMinutes = (((uint16_t) record[1]) << 8) | record[2];
+            nextSlot = (slot + 1) % WARMUP_SLOTS;
+        }
+    }
+
+    nextSeq = lastSeq + 1;
+
+    if (!isFound)
+    {
+        lastMinutes = 0;
+        offMinutes = WARMUP_OFF_UNKNOWN;
+        return;
+    }
+
+    //Supply loss by the cause of the reset
+    if (resetFlags & RSTCTRL_PORF_bm)
+    {
+        offMinutes = WARMUP_OFF_POR;
+    }
+    else if (resetFlags & RSTCTRL_BORF_bm)
+    {
+        offMinutes = WARMUP_OFF_BOR;
+    }
+    else if (resetFlags != 0)
+    {
+        offMinutes = WARMUP_OFF_WARM;
+    }
+    else
+    {
+        offMinutes = WARMUP_OFF_UNKNOWN;
+    }
+}
+
+//Credits the warm-up progress from before the reset, call as the heater starts
+void WARMUP_Restore(void)
+{
+    uint16_t credit = 0;
+
+    if (offMinutes != WARMUP_OFF_UNKNOWN)
+    {
+        //Time from the reset to now, the RTC has been running since start-up
+        uint32_t seconds = (((uint32_t) RTC_ReadCounter()) * 3600UL) / (RTC.PER + 1UL);
+        uint32_t off = offMinutes + ((seconds + 59UL) / 60UL);
+
+        uint32_t loss = off * WARMUP_LOSS_RATIO;
+
+        if ((off < WARMUP_COLD_MINUTES) && (loss < lastMinutes))
+        {
+            credit = lastMinutes - (uint16_t) loss;
+        }
+
+        if (credit > WARMUP_FULL_MINUTES)
+        {
+            credit = WARMUP_FULL_MINUTES;
+        }
+
+        LOG_3(LOG_WARMUP_CREDIT, credit, lastMinutes, (uint16_t) off);
+    }
+
+    APP_WarmupMinutesSet(credit);
+
+    //The last record no longer applies
+    savedMinutes = WARMUP_UNSAVED;
+    WARMUP_Checkpoint();
+}
+
+//Called once per tick, checkpoints the warm-up progress
+void WARMUP_Service(void)
+{
+    uint16_t minutes = _progressGet();
+
+    //Once complete, the log is not written until the next reset
+    if (minutes == savedMinutes)
+    {
+        return;
+    }
+
+    if ((savedMinutes == WARMUP_UNSAVED) || (minutes >= (savedMinutes + WARMUP_CHECKPOINT_MINUTES)) ||
+            (minutes == WARMUP_FULL_MINUTES))
+    {
+        WARMUP_Checkpoint();
+    }
+}
+
+//Writes a record of the warm-up progress, if it changed since the last checkpoint
+static bool _checkpointWrite(bool isEmergency)
+{
+    uint16_t minutes = _progressGet();
+
+    if (minutes == savedMinutes)
+    {
+        return true;
+    }
+
+    uint8_t record[WARMUP_RECORD_SIZE];
+    record[0] = nextSeq;
+    record[1] = (uint8_t) (minutes >> 8);
+    record[2] = (uint8_t) minutes;
+    record[3] = _crcCompute(record, WARMUP_RECORD_SIZE - 1);
+
+    //The CRC is written last, so a torn record is never valid
+    uint16_t addr = EEPROM_WARMUP_LOG_ADDR + (WARMUP_RECORD_SIZE * nextSlot);
+
+    for (uint8_t i = 0; i < WARMUP_RECORD_SIZE; i++)
+    {
+        bool isWritten = (isEmergency) ? EEPROM_EmergencyByteWrite(addr + i, record[i]) :
+                EEPROM_ByteWrite(addr + i, record[i]);
+
+        if (!isWritten)
+        {
+            return false;
+        }
+    }
+
+    nextSlot = (nextSlot + 1) % WARMUP_SLOTS;
+    nextSeq++;
+    savedMinutes = minutes;
+
+    return true;
+}
+
+//Writes the warm-up progress now, if it changed since the last checkpoint
+bool WARMUP_Checkpoint(void)
+{
+    return _checkpointWrite(false);
+}
+
+//Writes the warm-up progress while the supply is failing (power-fail flush only)
+bool WARMUP_EmergencyCheckpoint(void)
+{
+    return _checkpointWrite(true);
+}
@@ -0,0 +1,88 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef WARMUP_H
+#define	WARMUP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+/* Warm-up progress across resets
+ * 
+ * The warm-up progress (minutes) is checkpointed to a wear-levelled log in the EEPROM,
+ * outside the CRC / checksum protected data. Each record is written in a new slot,
+ * with a CRC-8 written last - a record torn by a brown-out is ignored, and the one before it is used.
+ * 
+ * Sensor thermal model:
+ * The sensor is conditioned while heated, and loses its conditioning while cold.
+ *   credit = progress - (WARMUP_LOSS_RATIO * minutes off)
+ * If the heater was off for WARMUP_COLD_MINUTES or more, the sensor is cold and there is no credit.
+ * 
+ * Minutes off = supply loss estimated from the reset cause (WARMUP_OFF_xxx)
+ *             + time from the reset to the heater starting (measured with the RTC)
+ * The WARMUP_OFF_xxx and model constants are the per-deployment policy.
+ * Set WARMUP_OFF_POR / BOR to WARMUP_OFF_UNKNOWN to never credit warm-up after a supply loss.
+ */
+    
+//Progress between checkpoints (minutes)
+#define WARMUP_CHECKPOINT_MINUTES 15
+    
+//Minutes of warm-up lost per minute off
+#define WARMUP_LOSS_RATIO 4
+    
+//Minutes off after which the sensor is cold
+#define WARMUP_COLD_MINUTES 60
+    
+//The supply loss can't be estimated
+#define WARMUP_OFF_UNKNOWN 0xFFFF
+    
+//Estimated supply loss per reset cause (minutes)
+#define WARMUP_OFF_POR WARMUP_OFF_UNKNOWN   //Power-on, off for an unknown time
+#define WARMUP_OFF_BOR 1                    //Brown-out, the supply dipped
+#define WARMUP_OFF_WARM 0                   //WDT, software, UPDI or pin, the supply was kept
+    
+//Size of a record: sequence, progress (2), CRC-8
+#define WARMUP_RECORD_SIZE 4
+    
+    //Finds the last checkpoint, and the warm-up credit for the cause of the reset
+    void WARMUP_Initialize(uint8_t resetFlags);
+    
+    //Credits the warm-up progress from before the reset, call as the heater starts
+    void WARMUP_Restore(void);
+    
+    //Called once per tick, checkpoints the warm-up progress
+    void WARMUP_Service(void);
+    
+    //Writes the warm-up progress now, if it changed since the last checkpoint
+    bool WARMUP_Checkpoint(void);
+    
+    //Writes the warm-up progress while the supply is failing (power-fail flush only)
+    bool WARMUP_EmergencyCheckpoint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* WARMUP_H */
@@ -0,0 +1,161 @@
+#include "WATCHDOG.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <avr/io.h>
+
+#include "mcc_generated_files/system/system.h"
+#include "TIMING.h"
+#include "TRACE.h"
+
+//Timestamp of the last kick
+static uint32_t lastKick = 0;
+static bool hasKicked = false;
+
+//Diagnostics completed since the last kick, and its complement for verification
+static uint8_t diagDone = 0;
+static uint8_t diagDoneCheck = 0xFF;
+
+//Kick interval statistics
+static uint16_t histogram[WATCHDOG_HIST_BINS];
+static uint16_t intervalMin = UINT16_MAX;
+static uint16_t intervalMax = 0;
+
+//Kicks skipped because the closed window had not elapsed
+static uint16_t kicksDeferred = 0;
+
+//Adds a kick interval to the statistics
+static void _intervalRecord(uint16_t interval)
+{
+    uint8_t bin = (uint8_t) (interval / WATCHDOG_HIST_BIN_MS);
+    if (bin >= WATCHDOG_HIST_BINS)
+    {
+        bin = WATCHDOG_HIST_BINS - 1;
+    }
+
+    if (histogram[bin] != UINT16_MAX)
+    {
+        histogram[bin]++;
+    }
+
+    if (interval < intervalMin)
+    {
+        intervalMin = interval;
+    }
+
+    if (interval > intervalMax)
+    {
+        intervalMax = interval;
+    }
+}
+
+//Starts the kick interval measurements, and verifies the WDT configuration
+void WATCHDOG_Initialize(void)
+{
+    //The WDT was started earlier by MCC, so the closed window has already begun
+    lastKick = TIMING_TimestampGet();
+    hasKicked = false;
+
+    diagDone = 0;
+    diagDoneCheck = 0xFF;
+
+    if (WATCHDOG_Verify() != DIAG_PASS)
+    {
+        printf("WDT configuration does not match the measured kick timing!\r\n");
+    }
+}
+
+//Reports a diagnostic as complete for this tick
+void WATCHDOG_DiagComplete(uint8_t diag)
+{
+    diagDone |= diag;
+    diagDoneCheck = ~diagDone;
+}
+
+//Clears the WDT if all diagnostics are complete and the closed window has elapsed
+bool WATCHDOG_Kick(void)
+{
+    //Variable corrupted, let the WDT expire
+    if (diagDone != (uint8_t) (~diagDoneCheck))
+    {
+        return false;
+    }
+
+    //Diagnostics incomplete, let the WDT expire
+    if (diagDone != WATCHDOG_DIAG_ALL)
+    {
+        TRACE_Log(TRACE_WDT_WITHHELD, diagDone);
+        return false;
+    }
+
+    uint32_t elapsed = TIMING_TICKS_TO_US(TIMING_ElapsedGet(lastKick)) / 1000UL;
+
+    //Too soon after the last kick (long tick followed by a short one), try again next tick
+    if (elapsed < WATCHDOG_KICK_MIN_MS)
+    {
+        kicksDeferred++;
+        TRACE_Log(TRACE_WDT_DEFERRED, 0);
+        return false;
+    }
+
+    //Clear WDT
+    asm("WDR");
+
+    lastKick = TIMING_TimestampGet();
+
+    //The first interval includes the start-up self-test
+    if (hasKicked)
+    {
+        _intervalRecord((elapsed > UINT16_MAX) ? UINT16_MAX : (uint16_t) elapsed);
+    }
+    hasKicked = true;
+
+    diagDone = 0;
+    diagDoneCheck = 0xFF;
+
+    return true;
+}
+
+//Verifies the WDT is running with the expected windows
+diag_result_t WATCHDOG_Verify(void)
+{
+    if (WDT.CTRLA != WATCHDOG_CTRLA)
+    {
+        return DIAG_FAIL;
+    }
+    else if (!(WDT.STATUS & WDT_LOCK_bm))
+    {
+        return DIAG_FAIL;
+    }
+
+    return DIAG_PASS;
+}
+
+//Returns the shortest kick interval (ms)
+uint16_t WATCHDOG_IntervalMinGet(void)
+{
+    return intervalMin;
+}
+
+//Returns the longest kick interval (ms)
+uint16_t WATCHDOG_IntervalMaxGet(void)
+{
+    return intervalMax;
+}
+
+//Prints the kick interval histogram
+void WATCHDOG_HistogramPrint(void)
+{
+    printf("WDT kicks: min = %u ms, max = %u ms, deferred = %u, accepted = %lu - %lu ms\r\n",
+            intervalMin, intervalMax, kicksDeferred,
+            WATCHDOG_KICK_MIN_MS, WATCHDOG_KICK_MAX_MS(WATCHDOG_PERIOD_CLK));
+
+    for (uint8_t i = 0; i < WATCHDOG_HIST_BINS; i++)
+    {
+        if (histogram[i] != 0)
+        {
+            printf("  %4lu ms: %u\r\n", i * WATCHDOG_HIST_BIN_MS, histogram[i]);
+        }
+    }
+}
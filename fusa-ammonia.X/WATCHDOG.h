@@ -0,0 +1,123 @@
+/*
+ [2024] Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef WATCHDOG_H
+#define	WATCHDOG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "mcc_generated_files/diagnostics/diag_common/diag_result_type.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
+    
+//Prints the kick interval histogram every hour
+//#define PRINT_WDT_HISTOGRAM
+    
+//The WDT runs from OSC32K / 32 = 1.024 kHz (no casts, used in #if)
+#define WATCHDOG_CLK_TO_MS(clk) (((clk) * 1000UL) / 1024UL)
+    
+//Nominal kick interval - one kick per 0.5s RTC tick
+#define WATCHDOG_INTERVAL_NOMINAL_MS 500UL
+    
+//Longest kick interval - a tick delayed by the hourly memory scan
+//Update from the histogram (PRINT_WDT_HISTOGRAM) if the scan changes
+#define WATCHDOG_INTERVAL_MAX_MS 2000UL
+    
+//Closed window - must end before the nominal kick, including the OSC32K tolerance
+#define WATCHDOG_WINDOW_CLK 256UL
+#define WATCHDOG_WINDOW WDT_WINDOW_256CLK_gc
+    
+//Earliest kick accepted, after the longest possible closed window
+#define WATCHDOG_KICK_MIN_MS ((WATCHDOG_CLK_TO_MS(WATCHDOG_WINDOW_CLK) * (100UL + DIAG_WDT_TOLERANCE_PCT)) / 100UL)
+    
+//Latest kick accepted with a period (open window) of clk cycles, with the shortest possible WDT clock
+#define WATCHDOG_KICK_MAX_MS(clk) ((WATCHDOG_CLK_TO_MS(WATCHDOG_WINDOW_CLK + (clk)) * (100UL - DIAG_WDT_TOLERANCE_PCT)) / 100UL)
+    
+#if (WATCHDOG_KICK_MIN_MS >= WATCHDOG_INTERVAL_NOMINAL_MS)
+#error The WDT closed window is longer than the nominal kick interval
+#endif
+    
+//Shortest open window that covers the longest kick interval
+#if (WATCHDOG_KICK_MAX_MS(1024UL) > WATCHDOG_INTERVAL_MAX_MS)
+#define WATCHDOG_PERIOD_CLK 1024UL
+#define WATCHDOG_PERIOD WDT_PERIOD_1KCLK_gc
+#elif (WATCHDOG_KICK_MAX_MS(2048UL) > WATCHDOG_INTERVAL_MAX_MS)
+#define WATCHDOG_PERIOD_CLK 2048UL
+#define WATCHDOG_PERIOD WDT_PERIOD_2KCLK_gc
+#elif (WATCHDOG_KICK_MAX_MS(4096UL) > WATCHDOG_INTERVAL_MAX_MS)
+#define WATCHDOG_PERIOD_CLK 4096UL
+#define WATCHDOG_PERIOD WDT_PERIOD_4KCLK_gc
+#elif (WATCHDOG_KICK_MAX_MS(8192UL) > WATCHDOG_INTERVAL_MAX_MS)
+#define WATCHDOG_PERIOD_CLK 8192UL
+#define WATCHDOG_PERIOD WDT_PERIOD_8KCLK_gc
+#else
+#error WATCHDOG_INTERVAL_MAX_MS does not fit in the longest WDT period
+#endif
+    
+//Expected WDT.CTRLA - WDT_Initialize (MCC) must be configured to match
+#define WATCHDOG_CTRLA (WATCHDOG_WINDOW | WATCHDOG_PERIOD)
+    
+//Kick interval histogram
+#define WATCHDOG_HIST_BINS 16
+#define WATCHDOG_HIST_BIN_MS 128UL
+    
+//Diagnostics that must complete in each tick before the WDT is cleared
+#define WATCHDOG_DIAG_SENSOR (1 << 0)
+#define WATCHDOG_DIAG_SRAM (1 << 1)
+#define WATCHDOG_DIAG_STATE (1 << 2)
+#define WATCHDOG_DIAG_SETPOINT (1 << 3)
+#define WATCHDOG_DIAG_HEATER (1 << 4)
+#define WATCHDOG_DIAG_CPU (1 << 5)
+#define WATCHDOG_DIAG_STACK (1 << 6)
+#define WATCHDOG_DIAG_INVARIANT (1 << 7)
+#define WATCHDOG_DIAG_ALL (0xFF)
+    
+    //Starts the kick interval measurements, and verifies the WDT configuration
+    void WATCHDOG_Initialize(void);
+    
+    //Reports a diagnostic as complete for this tick
+    void WATCHDOG_DiagComplete(uint8_t diag);
+    
+    //Clears the WDT if all diagnostics are complete and the closed window has elapsed
+    //Returns true if the WDT was cleared
+    bool WATCHDOG_Kick(void);
+    
+    //Verifies the WDT is running with the expected windows
+    diag_result_t WATCHDOG_Verify(void);
+    
+    //Returns the shortest kick interval (ms)
+    uint16_t WATCHDOG_IntervalMinGet(void);
+    
+    //Returns the longest kick interval (ms)
+    uint16_t WATCHDOG_IntervalMaxGet(void);
+    
+    //Prints the kick interval histogram
+    void WATCHDOG_HistogramPrint(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* WATCHDOG_H */
@@ -4,26 +4,31 @@
 #include <stdbool.h>
 
 #include "mcc_generated_files/system/system.h"
-#include "mcc_generated_files/timer/delay.h"
+#include "SENSOR.h"
+#include "EVENT.h"
+#include "CPUCLK.h"
+
+#include <util/atomic.h>
 
 static volatile uint8_t warmupHours = 0;
-static volatile bool WDT_ready = false;
-static volatile bool hasHourTicked = false;
 
 
 //Interrupt for an elapsed hour
 void APP_HourTick(void)
 {
     //Increment hours count
-    warmupHours++;
+    if (warmupHours < UINT8_MAX)
+    {
+        warmupHours++;
+    }
     
-    hasHourTicked = true;
+    EVENT_Post(EVENT_HOUR, warmupHours);
 }
 
 //Interrupt from the PIT (used for periodic self-test)
 void APP_PITTick(void)
 {
-    WDT_ready = true;
+    EVENT_Post(EVENT_TICK, 0);
 }
 
 //Reset the device
@@ -32,22 +37,39 @@ void APP_Reset(void)
     ccp_write_io((void*) &RSTCTRL.SWRR, RSTCTRL_SWRE_bm);
 }
 
-//Returns true if an hour has ticked
-bool APP_HasHourTicked(void)
+//Prints hours remaining in warmup
+void APP_RemainingHoursPrint(void)
 {
-    return hasHourTicked;
+    printf("Warmup time remaining: %d / %d hrs\r\n", warmupHours, WARM_UP_HOURS);
 }
 
-//Clear the hour tick flag
-void APP_HourTickClear(void)
+//Returns the warm-up progress (minutes)
+uint16_t APP_WarmupMinutesGet(void)
 {
-    hasHourTicked = false;
+    uint8_t hours;
+    uint16_t count;
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        hours = warmupHours;
+        count = RTC_ReadCounter();
+    }
+    
+    //The RTC overflows once per hour
+    return (((uint16_t) hours) * 60U) + (uint16_t) ((((uint32_t) count) * 60UL) / (RTC.PER + 1UL));
 }
 
-//Prints hours remaining in warmup
-void APP_RemainingHoursPrint(void)
+//Sets the warm-up progress, to credit warm-up from before a reset (minutes)
+void APP_WarmupMinutesSet(uint16_t minutes)
 {
-    printf("Warmup time remaining: %d / %d hrs\r\n", warmupHours, WARM_UP_HOURS);
+    uint16_t hours = minutes / 60U;
+    uint16_t count = (uint16_t) ((((uint32_t) (minutes % 60U)) * (RTC.PER + 1UL)) / 60UL);
+    
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        warmupHours = (hours > UINT8_MAX) ? UINT8_MAX : (uint8_t) hours;
+        RTC_WriteCounter(count);
+    }
 }
 
 //Returns true if sensor is ready
@@ -60,61 +82,77 @@ bool APP_IsSensorReady(void)
     return false;
 }
 
-//Returns true if ready to self-test
-bool APP_IsReadyForSelfTest(void)
-{
-    return WDT_ready;
-}
-
-//Clears the self-test flag
-void APP_SelfTestFlashClear(void)
+//Configures the comparators of the sensor channels not set up by MCC
+void APP_ComparatorsInitialize(void)
 {
-    WDT_ready = false;
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        const sensor_channel_config_t* config = SENSOR_ChannelConfigGet(ch);
+        
+        //AC1 is initialized by MCC
+        if (config->ac == &AC1)
+        {
+            continue;
+        }
+        
+        //Match the AC1 configuration, but on the channel's sensor input
+        config->ac->CTRLB = AC1.CTRLB;
+        config->ac->DACREF = AC1.DACREF;
+        config->ac->INTCTRL = AC1.INTCTRL;
+        config->ac->MUXCTRL = (AC1.MUXCTRL & ~(AC_MUXPOS_gm)) | config->acSensorMux;
+        config->ac->CTRLA = AC1.CTRLA;
+    }
 }
 
-//Connect the comparator to the gas sensor 
-void APP_SensorConnect(void)
+//Connect the comparator of a channel to the gas sensor 
+void APP_SensorConnect(uint8_t channel)
 {
+    const sensor_channel_config_t* config = SENSOR_ChannelConfigGet(channel);
+    
     //Clear the MUXPOS bits
-    AC1.MUXCTRL &= ~(AC_MUXPOS_gm);
+    config->ac->MUXCTRL &= ~(AC_MUXPOS_gm);
     
-    //AN1 (sensor) is on PD4, AINP2
-    AC1.MUXCTRL |= AC_MUXPOS_AINP2_gc;
+    //Sensor input of the channel (CH0: AN1 on PD4, AINP2)
+    config->ac->MUXCTRL |= config->acSensorMux;
 }
 
-//Connect the comparator to the DAC output
-void APP_DACConnect(void)
+//Connect the comparator of a channel to the DAC output
+void APP_DACConnect(uint8_t channel)
 {
+    const sensor_channel_config_t* config = SENSOR_ChannelConfigGet(channel);
+    
     //Clear the MUXPOS bits
-    AC1.MUXCTRL &= ~(AC_MUXPOS_gm);
+    config->ac->MUXCTRL &= ~(AC_MUXPOS_gm);
     
-    //DAC0 is on PD6, AINP3
-    AC1.MUXCTRL |= AC_MUXPOS_AINP3_gc;
+    //DAC0 is on PD6 (AINP3 on CH0)
+    config->ac->MUXCTRL |= config->acDACMux;
 }
 
-//Gets the current DACREF on AC1
-uint8_t APP_DACREFGet(void)
+//Gets the current DACREF on the comparator of a channel
+uint8_t APP_DACREFGet(uint8_t channel)
 {
-    return AC1.DACREF;
+    return SENSOR_ChannelConfigGet(channel)->ac->DACREF;
 }
 
-//Sets a new DACREF on AC1
-void APP_DACREFSet(uint8_t val)
+//Sets a new DACREF on the comparator of a channel
+void APP_DACREFSet(uint8_t channel, uint8_t val)
 {
+    AC_t* ac = SENSOR_ChannelConfigGet(channel)->ac;
+    
     //Disable Interrupts
-    AC1.INTCTRL &= ~AC_CMP_bm;
+    ac->INTCTRL &= ~AC_CMP_bm;
     
-    //Update DACREF for AC1
-    AC1_DACRefValueSet(val);
+    //Update DACREF
+    ac->DACREF = val;
     
     //Wait a few microseconds...
-    DELAY_microseconds(10);
+    CPUCLK_DelayMicroseconds(10);
     
     //Clear ISR Flag
-    AC1.STATUS |= AC_CMPIF_bm;
+    ac->STATUS |= AC_CMPIF_bm;
     
     //Re-enable Interrupts
-    AC1.INTCTRL |= AC_CMP_bm;
+    ac->INTCTRL |= AC_CMP_bm;
 }
 
 //Runs a CRC Scan (Blocking)
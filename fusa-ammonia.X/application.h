@@ -31,15 +31,44 @@
 extern "C" {
 #endif
     
+//If defined, AC1 sounds the buzzer through EVSYS and the CCL, without the CPU (see ALARM.h)
+//The buzzer must be connected to the LUT2 output (PD3)
+//#define FUSA_ENABLE_HW_ALARM
+    
+//If defined, DAC0 and AC1 measure the sensor every tick, as a cross-check of ADC0 (see ACADC.h)
+//The sensor must also be connected to the AC1 negative input (ACADC_SENSOR_MUXNEG)
+//#define FUSA_ENABLE_AC_ADC
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+#include "ALARM.h"
+    
+//Forces the alarm buzzer on
+#define BUZZER_ENABLE() ALARM_BuzzerForce(true)
+    
+//Stops forcing the alarm buzzer - it still sounds while armed and AC1 is tripped
+#define BUZZER_DISABLE() ALARM_BuzzerForce(false)
+    
+//Returns true if the alarm buzzer is forced on
+#define BUZZER_IS_ENABLED() ALARM_IsBuzzerForced()
+#else
 //Enables the alarm buzzer
-#define BUZZER_ENABLE() do { TCA0_Start(); } while (0)
+//TCA0 also drives the heater PWM, so the buzzer output (WO1) is gated instead of stopping the timer
+#define BUZZER_ENABLE() do { TCA0.SINGLE.CTRLB |= TCA_SINGLE_CMP1EN_bm; TCA0_Start(); } while (0)
     
 //Disables the alarm buzzer
-#define BUZZER_DISABLE() do { TCA0_Stop(); BUZZER_SetLow(); } while (0)
+#define BUZZER_DISABLE() do { TCA0.SINGLE.CTRLB &= ~TCA_SINGLE_CMP1EN_bm; BUZZER_SetLow(); } while (0)
+    
+//Returns true if the alarm buzzer is sounding
+#define BUZZER_IS_ENABLED() ((TCA0.SINGLE.CTRLB & TCA_SINGLE_CMP1EN_bm) && (TCA0.SINGLE.CTRLA & TCA_SINGLE_ENABLE_bm))
+#endif
 
 //Number of hours to warmup for
 #define WARM_UP_HOURS 24
     
+//If defined, the heater starts once the CPU, WDT and SRAM tests pass, and the other start-up tests run during the pre-heat
+//If not defined, the heater starts after all start-up tests
+#define FUSA_ENABLE_FAST_BOOT
+    
 //If defined, the class B library uses a 16-bit CRC to verify EEPROM
 //If not defined, a 16-bit checksum is used instead
 //#define FUSA_ENABLE_EEPROM_SIMPLE_CHECKSUM
@@ -57,36 +86,27 @@ extern "C" {
     //Reset the device
     void APP_Reset(void);
     
-    //Returns true if an hour has ticked
-    bool APP_HasHourTicked(void);
-    
-    //Clear the hour tick flag
-    void APP_HourTickClear(void);
-    
     //Prints hours remaining in warmup
     void APP_RemainingHoursPrint(void);
     
     //Returns true if sensor is ready
     bool APP_IsSensorReady(void);
-
-    //Returns true if ready to self-test
-    bool APP_IsReadyForSelfTest(void);
     
-    //Clears the self-test flag
-    void APP_SelfTestFlashClear(void);
+    //Configures the comparators of the sensor channels not set up by MCC
+    void APP_ComparatorsInitialize(void);
     
-    //Connect the comparator to the gas sensor 
-    void APP_SensorConnect(void);
+    //Connect the comparator of a channel to the gas sensor 
+    void APP_SensorConnect(uint8_t channel);
     
-    //Connect the comparator to the DAC output
-    void APP_DACConnect(void);
+    //Connect the comparator of a channel to the DAC output
+    void APP_DACConnect(uint8_t channel);
     
-    //Gets the current DACREF on AC1
-    uint8_t APP_DACREFGet(void);
+    //Gets the current DACREF on the comparator of a channel
+    uint8_t APP_DACREFGet(uint8_t channel);
     
-    //Sets a new DACREF on AC1
-    //Disables AC1 interrupt, updates value, waits, then re-enables
-    void APP_DACREFSet(uint8_t val);
+    //Sets a new DACREF on the comparator of a channel
+    //Disables AC interrupt, updates value, waits, then re-enables
+    void APP_DACREFSet(uint8_t channel, uint8_t val);
     
     //Runs a CRC Scan (Blocking)
     //Returns true if successful 
@@ -95,6 +115,12 @@ extern "C" {
     //Returns the VLM Status
     bool APP_VLMStatusGet(void);
     
+    //Returns the warm-up progress (minutes)
+    uint16_t APP_WarmupMinutesGet(void);
+    
+    //Sets the warm-up progress, to credit warm-up from before a reset (minutes)
+    void APP_WarmupMinutesSet(uint16_t minutes);
+    
 #ifdef	__cplusplus
 }
 #endif
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 
 #include <avr/io.h>
+#include <avr/sleep.h>
 
 #include "mcc_generated_files/system/system.h"
 #include "mcc_generated_files/timer/delay.h"
@@ -11,15 +12,27 @@
 #include "application.h"
 #include "SENSOR.h"
 #include "EEPROM.h"
+#include "CURVE.h"
+#include "HEATER.h"
+#include "TIMING.h"
+#include "WATCHDOG.h"
+#include "TRACE.h"
+#include "STACK.h"
+#include "FAULT.h"
+#include "LOG.h"
+#include "PFM.h"
+#include "PATTERN.h"
+#include "ACTEST.h"
+#include "ACCHAR.h"
+#include "ACADC.h"
+#include "BOOT.h"
+#include "CPUCLK.h"
 #include "mcc_generated_files/diagnostics/diag_library/memory/non_volatile/diag_flash_crc32.h"
 #include "mcc_generated_files/diagnostics/diag_library/cpu/diag_cpu_registers.h"
 #include "mcc_generated_files/diagnostics/diag_library/memory/volatile/diag_sram_marchc_minus.h"
 #include "mcc_generated_files/diagnostics/diag_library/wdt/diag_wdt_startup.h"
 #include "mcc_generated_files/diagnostics/diag_library/memory/non_volatile/diag_eeprom_crc16.h"
 
-#define PASS_STRING "OK\r\n"
-#define FAIL_STRING "FAIL\r\n"
-
 #define CRC_ADDRESS_START 0xFFFC
 
 #ifndef TEST_CHECKSUM
@@ -37,16 +50,89 @@ extern const uint32_t flashChecksum __at((CRC_ADDRESS_START));
 static volatile const uint32_t flashChecksum __at((CRC_ADDRESS_START)) = 0x87654321;
 #endif
 
+//Reference gas concentrations for a button driven curve calibration
+static const uint16_t curveCalPPM[CURVE_CAL_POINTS] = CURVE_CAL_PPM;
+
+//SRAM March C- coverage
+static uint8_t sramSections = 0;            //Sections tested in the current pass
+static uint32_t sramPassStart = 0;          //Timestamp of the first section of the pass
+static uint32_t sramPassTime = 0;           //Duration of the last full pass (ms)
+static uint32_t sramPassTimeWorst = 0;      //Longest full pass (ms)
+static uint32_t sramSectionTicks = 0;       //Worst-case time for one section
+
 static volatile system_state_t sysState = SYS_ERROR;
 static volatile system_state_t sysStateCheck = SYS_ERROR;
 
+//Number of states the state machine can be in at the end of a tick
+#define SYS_STATE_COUNT (SYS_CALIBRATE_CURVE + 1)
+#define SYS_STATE_BIT(state) (1 << (state))
+
+//Transitions the state machine may make in one tick (SYS_ERROR is always allowed)
+static const uint8_t stateTransitions[SYS_STATE_COUNT] = {
+    [SYS_WARMUP] = SYS_STATE_BIT(SYS_WARMUP) | SYS_STATE_BIT(SYS_CALIBRATE) | SYS_STATE_BIT(SYS_MONITOR) | SYS_STATE_BIT(SYS_ALARM),
+    [SYS_CALIBRATE] = SYS_STATE_BIT(SYS_CALIBRATE) | SYS_STATE_BIT(SYS_MONITOR) | SYS_STATE_BIT(SYS_CALIBRATE_CURVE),
+    [SYS_MONITOR] = SYS_STATE_BIT(SYS_MONITOR) | SYS_STATE_BIT(SYS_CALIBRATE) | SYS_STATE_BIT(SYS_ALARM),
+    [SYS_ALARM] = SYS_STATE_BIT(SYS_ALARM) | SYS_STATE_BIT(SYS_MONITOR),
+    [SYS_CALIBRATE_CURVE] = SYS_STATE_BIT(SYS_CALIBRATE_CURVE) | SYS_STATE_BIT(SYS_MONITOR),
+};
+
+//Transitions observed since start-up
+static uint8_t stateCoverage[SYS_STATE_COUNT];
+
+//Concentration telemetry, printed every telemetryTicks ticks (0 = off)
+static uint16_t telemetryTicks = 1;
+static uint16_t telemetryCount = 0;
+static uint16_t lastPPM[SENSOR_CHANNEL_COUNT];
+
+//Hours since AC1 was last characterised
+static uint8_t acCharHours = 0;
+
 //Sets the system state
 void FUSA_SystemStateSet(system_state_t state)
 {
+#ifdef FUSA_FAULT_INJECTION
+    //Injected faults are repaired instead of entering the failure handler
+    if (FAULT_StateIntercept(state))
+    {
+        return;
+    }
+#endif
+    
+    if (state != sysState)
+    {
+        TRACE_Log(TRACE_STATE, (uint8_t) state);
+    }
+    
     sysState = state;
     sysStateCheck = state;
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    //AC1 sounds the buzzer on its own while monitoring, the comparator test re-arms it when done
+    ALARM_Arm(((state == SYS_MONITOR) || (state == SYS_ALARM)) && !ACTEST_IsRunning());
+#endif
+}
+
+//Returns the system state
+system_state_t FUSA_SystemStateGet(void)
+{
+    return sysState;
 }
 
+#ifdef FUSA_FAULT_INJECTION
+//Flips bits of the system state, or of its verification copy
+void FUSA_StateFaultInject(uint8_t mask, bool isCheck)
+{
+    if (isCheck)
+    {
+        sysStateCheck = (system_state_t) (sysStateCheck ^ mask);
+    }
+    else
+    {
+        sysState = (system_state_t) (sysState ^ mask);
+    }
+}
+#endif
+
 //Returns DIAG_FAIL if unable to verify the system state
 diag_result_t FUSA_SystemStateVerify(void)
 {
@@ -57,10 +143,142 @@ diag_result_t FUSA_SystemStateVerify(void)
     return DIAG_PASS;
 }
 
+//Returns the LED cadence of a state
+static pattern_t _statePatternGet(system_state_t state)
+{
+    switch (state)
+    {
+        case SYS_MONITOR:
+        {
+            return PATTERN_HEARTBEAT;
+        }
+        case SYS_ALARM:
+        {
+            return PATTERN_ALARM;
+        }
+        default:
+        {
+            return PATTERN_OFF;
+        }
+    }
+}
+
+//Verifies the invariants of the state machine after it has run
+static diag_result_t _stateInvariantVerify(system_state_t prevState)
+{
+    system_state_t state = sysState;
+    
+    //Reported by the diagnostic that set it
+    if (state == SYS_ERROR)
+    {
+        return DIAG_PASS;
+    }
+    
+    //SYS_INIT and SYS_SELF_TEST never last beyond a test
+    if ((state < 0) || (state >= SYS_STATE_COUNT) || (prevState < 0) || (prevState >= SYS_STATE_COUNT))
+    {
+        return DIAG_FAIL;
+    }
+    else if (!(stateTransitions[prevState] & SYS_STATE_BIT(state)))
+    {
+        return DIAG_FAIL;
+    }
+    
+    stateCoverage[prevState] |= SYS_STATE_BIT(state);
+    
+    //The buzzer sounds in SYS_ALARM, and only in SYS_ALARM
+    if ((state == SYS_ALARM) != (bool) BUZZER_IS_ENABLED())
+    {
+        return DIAG_FAIL;
+    }
+    
+    switch (state)
+    {
+        case SYS_MONITOR:
+        case SYS_ALARM:
+        {
+            //Never monitoring without a valid calibration, or with the heater off
+            if (!SENSOR_IsEEPROMValid() || (HEATER_PhaseGet() == HEATER_OFF))
+            {
+                return DIAG_FAIL;
+            }
+            break;
+        }
+        case SYS_CALIBRATE_CURVE:
+        {
+            //The curve is calibrated relative to a valid zero-point
+            if (!SENSOR_IsEEPROMValid())
+            {
+                return DIAG_FAIL;
+            }
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+    
+    return DIAG_PASS;
+}
+
+//Tests the next section of SRAM, and tracks the coverage
+static diag_result_t _SRAMSectionRun(void)
+{
+    uint32_t start = TIMING_TimestampGet();
+    
+    if (sramSections == 0)
+    {
+        sramPassStart = start;
+    }
+    
+    CPUCLK_Boost(CPUCLK_SRAM);
+    diag_result_t result = DIAG_SRAM_MarchPeriodic();
+    CPUCLK_Release(CPUCLK_SRAM);
+    
+    //Track the worst-case section time
+    uint32_t ticks = TIMING_ElapsedGet(start);
+    if (ticks > sramSectionTicks)
+    {
+        sramSectionTicks = ticks;
+    }
+    
+    //Full pass of SRAM complete?
+    sramSections++;
+    if (sramSections >= FUSA_SRAM_SECTIONS)
+    {
+        sramSections = 0;
+        sramPassTime = TIMING_TICKS_TO_US(TIMING_ElapsedGet(sramPassStart)) / 1000UL;
+        
+        if (sramPassTime > sramPassTimeWorst)
+        {
+            sramPassTimeWorst = sramPassTime;
+        }
+    }
+    
+    return result;
+}
+
+//Starts the sensor heater, unless a start-up test has failed
+static void _heaterStart(void)
+{
+#ifndef DEVELOP_MODE
+    if (sysState == SYS_ERROR)
+    {
+        return;
+    }
+#endif
+    
+    HEATER_Start();
+    BOOT_StageEnd(BOOT_STAGE_HEATER);
+}
+
 //Runs a self-test of the system
 bool FUSA_StartupSelfTestRun(void)
 {
-    printf("\r\nRunning Self Test\r\n");
+    BOOT_StageEnd(BOOT_STAGE_INIT);
+    
+    LOG_0(LOG_SELF_TEST_START);
     
     //Run the buzzer during self-test
     BUZZER_ENABLE();
@@ -75,76 +293,103 @@ bool FUSA_StartupSelfTestRun(void)
         //Erase requested by user
         SENSOR_EEPROMErase();
                 
-        printf("Configuration ERASED\r\n");
+        LOG_0(LOG_CONFIG_ERASED);
     }
     
-    printf("Flash Memory Checksum = 0x%lx\r\n\r\n", FUSA_PFMChecksumGet());
+    LOG_1(LOG_FLASH_CHECKSUM, FUSA_PFMChecksumGet());
     
     //Check CPU
-    printf("Testing CPU...");
+    LOG_0(LOG_TEST_CPU);
     if (FUSA_CPUTest())
-        printf(PASS_STRING);
+        LOG_0(LOG_PASS);
     else
     {
-        printf(FAIL_STRING);
+        LOG_0(LOG_FAIL);
         FUSA_SystemStateSet(SYS_ERROR);
     }
     
     //Get the WDT Result
-    printf("Testing WDT...");
+    LOG_0(LOG_TEST_WDT);
     if (FUSA_WDTTest())
-        printf(PASS_STRING);
+        LOG_0(LOG_PASS);
     else
     {
-        printf(FAIL_STRING);
+        LOG_0(LOG_FAIL);
         FUSA_SystemStateSet(SYS_ERROR);
     }
 
     //Get the SRAM Result
-    printf("Testing SRAM...");
+    LOG_0(LOG_TEST_SRAM);
     if (FUSA_SRAMTest())
-        printf(PASS_STRING);
+        LOG_0(LOG_PASS);
     else
     {
-        printf(FAIL_STRING);
+        LOG_0(LOG_FAIL);
         FUSA_SystemStateSet(SYS_ERROR);
     }
     
-    //Check Memory
-    printf("Testing Memory Integrity...");
-    if (FUSA_FlashTest())
-        printf(PASS_STRING);
-    else
+    BOOT_StageEnd(BOOT_STAGE_PREREQ);
+    
+#ifdef FUSA_ENABLE_FAST_BOOT
+    //The heater only needs a working CPU, WDT and SRAM
+    //A later failure turns it off again, and all tests complete before the warm-up starts
+    _heaterStart();
+    
+    if (sysState != SYS_ERROR)
     {
-        printf(FAIL_STRING);
-        FUSA_SystemStateSet(SYS_ERROR);
+        LOG_0(LOG_HEATER_EARLY);
     }
+#endif
     
-    //Check Comparator
-    printf("Testing Analog Comparator...");
-    if (FUSA_ACTest())
-        printf(PASS_STRING);
+    //Check Memory
+    LOG_0(LOG_TEST_MEMORY);
+    if (FUSA_FlashTest())
+        LOG_0(LOG_PASS);
     else
     {
-        printf(FAIL_STRING);
+        LOG_0(LOG_FAIL);
         FUSA_SystemStateSet(SYS_ERROR);
     }
+    
+    BOOT_StageEnd(BOOT_STAGE_FLASH);
         
     //Check EEPROM for valid constants
-    printf("Calibration data...");
+    LOG_0(LOG_TEST_CALIBRATION);
     if (FUSA_EEPROMTest())
     {        
         //Init R_L constant from EEPROM
         SENSOR_EEPROMInit();
         
         //EEPROM OK
-        printf(PASS_STRING);
+        LOG_0(LOG_PASS);
     }
     else
     {
         //No valid calibration found in EEPROM
-        printf("INVALID\r\n");
+        LOG_0(LOG_INVALID);
+    }
+    
+    BOOT_StageEnd(BOOT_STAGE_EEPROM);
+    
+    //Check Comparator, at the setpoint loaded from the EEPROM
+    LOG_0(LOG_TEST_AC);
+    if (FUSA_ACTest() && FUSA_ACCharacterize())
+        LOG_0(LOG_PASS);
+    else
+    {
+        LOG_0(LOG_FAIL);
+        FUSA_SystemStateSet(SYS_ERROR);
     }
+    
+    BOOT_StageEnd(BOOT_STAGE_AC);
+    
+#ifndef FUSA_ENABLE_FAST_BOOT
+    //Start the heater once all start-up tests have passed
+    _heaterStart();
+#endif
+    
+    //Return the RTC to counting the warm-up hours
+    BOOT_Complete();
         
     DELAY_microseconds(100);
     
@@ -172,7 +417,7 @@ bool FUSA_StartupSelfTestRun(void)
     
     if (sysState == SYS_ERROR)
     {
-        printf("\r\nWARNING: Start-up test failed. Continuing startup...\r\n");
+        LOG_0(LOG_SELF_TEST_CONTINUE);
         FUSA_SystemStateSet(SYS_WARMUP);
     }
 #endif
@@ -183,12 +428,12 @@ bool FUSA_StartupSelfTestRun(void)
     //Check to see if any error occurred
     if (sysState == SYS_ERROR)
     {
-        printf("Self Test Failed\r\n\r\n");
+        LOG_0(LOG_SELF_TEST_FAILED);
         FUSA_HandleSystemFailure();
     }
     else
     {
-        printf("Self Test Complete\r\n\r\nBeginning %u hour sensor warmup\r\n", WARM_UP_HOURS);
+        LOG_1(LOG_SELF_TEST_COMPLETE, WARM_UP_HOURS);
         FUSA_SystemStateSet(SYS_WARMUP);
     }
     
@@ -223,15 +468,8 @@ bool FUSA_ACTest(void)
      * 
      * 1. Save current system state.
      * 2. Set state to SYS_SELF_TEST.
-     * 3. Switch In+ to DAC0 Output (PD6, AINP3)
-     * 4. Set DAC0 to a value greater than DACREF
-     * 5. Wait for value to stabilize 
-     * 6. Check comparator output is HIGH
-     * 7. Set DAC0 to a value lower than DACREF
-     * 8. Wait for value to stabilize
-     * 9. Check comparator output is LOW
-     * 10. Switch In+ back to Ammonia Sensor (PD4, AINP2)
-     * 11. Return to previous state
+     * 3. Run the comparator test of every channel to completion
+     * 4. Return to previous state
      */
     
     //Save current state
@@ -240,62 +478,37 @@ bool FUSA_ACTest(void)
     //Switch to test state
     FUSA_SystemStateSet(SYS_SELF_TEST);
     
-    //Switch AC0 Input
-    APP_DACConnect();
-    
-    //DAC0 is 10-bit, DACREF is 8-bit
-    
-    //Set to DACREF + MARGIN
-    int16_t testVal = (APP_DACREFGet() << 2) + TEST_MARGIN;
-    
-    //Limit to a 10-bit number
-    if (testVal >= 0x3FF)
+    if (ACTEST_Run() != DIAG_PASS)
     {
-        testVal = 0x3FF;
-    }
-    
-    //Set to Alarm state
-    DAC0_SetOutput(testVal);
-    
-    //Wait 7us (DAC0 Settling) + 0.15us (AC Response)
-    DELAY_microseconds(8);
-    
-    //Is the signal HIGH?
-    if (AC1_Read())
-    {
-        //AC0 is malfunctioning, change to SYS_ERROR
+        //AC is malfunctioning, change to SYS_ERROR
         FUSA_SystemStateSet(SYS_ERROR);
         return false;
     }
     
-    //Set to DACREF - TEST_MARGIN
-    testVal = (APP_DACREFGet() << 2) - TEST_MARGIN;
-    
-    //If less than 0, set to 0
-    if (testVal < 0)
-    {
-        testVal = 0;
-    }
-    
-    //Set to low value
-    DAC0_SetOutput(testVal);
+    //Restore system state
+    FUSA_SystemStateSet(prevState);
     
-    //Wait 7us (DAC0 Settling) + 0.15us (AC Response)
-    DELAY_microseconds(8);
+    return true;
+}
+
+//Characterise AC1, and tighten the comparator test
+bool FUSA_ACCharacterize(void)
+{
+    diag_result_t result = ACCHAR_Run();
     
-    //Is the signal LOW?
-    if (!AC1_Read())
+    if (result == DIAG_FAIL)
     {
-        //AC0 is malfunctioning, change to SYS_ERROR
+        //Stuck, slow, or offset beyond the test margin
+        LOG_0(LOG_AC_CHAR_ERROR);
         FUSA_SystemStateSet(SYS_ERROR);
         return false;
     }
-    
-    //Switch AC back to Sensor
-    APP_SensorConnect();
-    
-    //Restore system state
-    FUSA_SystemStateSet(prevState);
+    else if ((result == DIAG_PASS) && ACCHAR_IsDrifting())
+    {
+        //Still passes, but has moved since power-up
+        const acchar_result_t* last = ACCHAR_LastGet();
+        LOG_3(LOG_AC_DRIFT, last->trip, ACCHAR_TICKS_TO_NS(last->rise), ACCHAR_TICKS_TO_NS(last->fall));
+    }
     
     return true;
 }
@@ -303,18 +516,22 @@ bool FUSA_ACTest(void)
 //Run a memory self-check
 bool FUSA_FlashTest(void)
 {    
+    bool isPass;
+    
+    CPUCLK_Boost(CPUCLK_FLASH);
+    
 #ifndef FUSA_ENABLE_FLASH_HW_SCAN
     //Class B Library Mode
-    if (DIAG_FLASH_ValidateCRC(DIAG_FLASH_START_ADDR, (DIAG_FLASH_CRC_STORE_ADDR), DIAG_FLASH_CRC_STORE_ADDR)
-            == DIAG_PASS)
-    {
-        return true;
-    }
-    return false;
+    isPass = (DIAG_FLASH_ValidateCRC(DIAG_FLASH_START_ADDR, (DIAG_FLASH_CRC_STORE_ADDR), DIAG_FLASH_CRC_STORE_ADDR)
+            == DIAG_PASS);
 #else
     //Hardware Mode
-    return APP_HardwareCRCRun();
+    isPass = APP_HardwareCRCRun();
 #endif
+    
+    CPUCLK_Release(CPUCLK_FLASH);
+    
+    return isPass;
 }
 
 //Run an SRAM self-test
@@ -395,45 +612,132 @@ void FUSA_EEPROMInvalidate(void)
 void FUSA_PeriodicSelfCheckRun(void)
 {    
     static bool prevButtonState = false;
+    static uint8_t curvePoint = 0;
     bool isPressed = false;
     
-    //Clear WDT
-    asm("WDR");
+    uint16_t meas[SENSOR_CHANNEL_COUNT];
     
-    //Get a new ADC reading from the sensor (blocking!)
-    uint16_t meas = SENSOR_SampleSensor();
+    //Get a new ADC reading from each sensor channel (blocking!)
+    TRACE_StageSet(TRACE_STAGE_SENSOR);
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        meas[ch] = SENSOR_SampleSensor(ch);
             
 #ifdef VIEW_RAW_ADC
-    printf("ADC Result: 0x%x\r\n", meas);
+        LOG_2(LOG_ADC_RESULT, ch, meas[ch]);
+#endif
+    }
+    WATCHDOG_DiagComplete(WATCHDOG_DIAG_SENSOR);
+    
+#ifdef FUSA_ENABLE_AC_ADC
+    //Measure the sensor again with DAC0 and AC1, and compare with ADC0
+    TRACE_StageSet(TRACE_STAGE_AC_ADC);
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    //AC1 crosses the sensor voltage, keep the buzzer quiet
+    ALARM_Arm(false);
+#endif
+    
+    if (ACADC_Verify(meas[ACADC_CHANNEL]) != DIAG_PASS)
+    {
+        LOG_3(LOG_ADC_MISMATCH, ACADC_CHANNEL, meas[ACADC_CHANNEL], ACADC_LastGet());
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    ALARM_Arm((sysState == SYS_MONITOR) || (sysState == SYS_ALARM));
+#endif
 #endif
     
     //Test SRAM
-    if (DIAG_SRAM_MarchPeriodic() != DIAG_PASS)
+    TRACE_StageSet(TRACE_STAGE_SRAM);
+    if (_SRAMSectionRun() != DIAG_PASS)
     {
-        printf("SRAM Failed Self-Test\r\n");
+        LOG_0(LOG_SRAM_ERROR);
         FUSA_SystemStateSet(SYS_ERROR);
     }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_SRAM);
+    }
     
     //Verify the State Machine Variable
+    TRACE_StageSet(TRACE_STAGE_STATE);
     if (FUSA_SystemStateVerify() != DIAG_PASS)
     {
-        printf("State Machine RAM Error\r\n");
+        LOG_0(LOG_STATE_ERROR);
         FUSA_SystemStateSet(SYS_ERROR);
     }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_STATE);
+    }
     
     //Verify the DACREF Value
+    TRACE_StageSet(TRACE_STAGE_SETPOINT);
     if (SENSOR_SetpointVerify() != DIAG_PASS)
     {
-        printf("DACREF Register Error\r\n");
+        LOG_0(LOG_DACREF_ERROR);
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_SETPOINT);
+    }
+    
+    //Verify the heater PWM
+    TRACE_StageSet(TRACE_STAGE_HEATER);
+    if (HEATER_Verify() != DIAG_PASS)
+    {
+        LOG_0(LOG_HEATER_ERROR);
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_HEATER);
+    }
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    //Cross-check the hardware alarm path against AC1
+    TRACE_StageSet(TRACE_STAGE_ALARM_PATH);
+    if (ALARM_Verify() != DIAG_PASS)
+    {
+        LOG_0(LOG_ALARM_PATH_ERROR);
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+#endif
+    
+    //Verify the WDT windows
+    TRACE_StageSet(TRACE_STAGE_WDT);
+    if (WATCHDOG_Verify() != DIAG_PASS)
+    {
+        LOG_0(LOG_WDT_ERROR);
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+    
+    //Check the stack high-water mark
+    TRACE_StageSet(TRACE_STAGE_STACK);
+    if (STACK_Scan() != DIAG_PASS)
+    {
+        LOG_0(LOG_STACK_ERROR);
         FUSA_SystemStateSet(SYS_ERROR);
     }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_STACK);
+    }
     
     //Run CPU Register Test
+    TRACE_StageSet(TRACE_STAGE_CPU);
     if (!FUSA_CPUTest())
     {
-        printf("CPU Failure\r\n");
+        LOG_0(LOG_CPU_ERROR);
         FUSA_SystemStateSet(SYS_ERROR);
     }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_CPU);
+    }
     
     //Simple one-shot button handler
     if (SW0_GetValue())
@@ -449,7 +753,17 @@ void FUSA_PeriodicSelfCheckRun(void)
     //Update state
     prevButtonState = SW0_GetValue();
     
+    //Is the concentration telemetry due?
+    bool isTelemetryDue = false;
+    if ((telemetryTicks != 0) && (++telemetryCount >= telemetryTicks))
+    {
+        telemetryCount = 0;
+        isTelemetryDue = true;
+    }
+    
     //Run state machine
+    TRACE_StageSet(TRACE_STAGE_STATE_MACHINE);
+    system_state_t prevState = sysState;
     switch (sysState)
     {
         case SYS_WARMUP:
@@ -459,14 +773,14 @@ void FUSA_PeriodicSelfCheckRun(void)
             //Sensor is now ready
             if (APP_IsSensorReady())
             {
-                printf("\r\nWarmup complete.\r\n");
+                LOG_0(LOG_WARMUP_COMPLETE);
                 
                 if (SENSOR_IsEEPROMValid())
                 {
                     //Ready to begin active monitoring
                     
                     //If the alarm is active, jump to alarm
-                    if (SENSOR_IsTripped())
+                    if (SENSOR_IsAnyTripped())
                     {
                         //Activate the alarm, and transition to a new state
                         FUSA_AlarmActivate();
@@ -479,19 +793,10 @@ void FUSA_PeriodicSelfCheckRun(void)
                 else
                 {
                     //Calibration Required
-                    printf("Calibration data not found. Press SW0 to set new zero-point.\r\n");
+                    LOG_0(LOG_CALIBRATION_NOT_FOUND);
                     FUSA_SystemStateSet(SYS_CALIBRATE);
                 }
             }
-            else
-            {
-                //Has an hour elapsed?
-                if (APP_HasHourTicked())
-                {
-                    //Print message
-                    APP_RemainingHoursPrint();
-                }
-            }
             
             break;
         }
@@ -504,13 +809,13 @@ void FUSA_PeriodicSelfCheckRun(void)
             {
                 //Run calibration
                 
-                printf("Running calibration.\r\n");
+                LOG_0(LOG_CALIBRATION_RUNNING);
                 
                 if (SENSOR_Calibrate())
                 {
                     //No errors
                     
-                    printf("Calibration complete. System is now ready.\r\n");
+                    LOG_0(LOG_CALIBRATION_COMPLETE);
                     
                     
                     //Since calibration just completed, it would be odd to immediately switch to SYS_ALARM
@@ -521,44 +826,100 @@ void FUSA_PeriodicSelfCheckRun(void)
                 {
                     //Something went wrong
                     
-                    printf("Calibration failed to complete.\r\n");
+                    LOG_0(LOG_CALIBRATION_FAILED);
                     FUSA_SystemStateSet(SYS_ERROR);
                 }
                 
             }
+            else if (TEST_BUTTON_GetValue() && SENSOR_IsEEPROMValid())
+            {
+                //Multi-point calibration of the gas curve, relative to the current zero-point
+                curvePoint = 0;
+                SENSOR_CurveCaptureStart();
+                
+                LOG_1(LOG_CURVE_START, curveCalPPM[curvePoint]);
+                FUSA_SystemStateSet(SYS_CALIBRATE_CURVE);
+            }
             
             break;
         }
-        case SYS_MONITOR:
+        case SYS_CALIBRATE_CURVE:
         {
-            //Flash the LED
-            LED0_SetHigh();
-            DELAY_milliseconds(1);
-            LED0_SetLow();
+            //Capturing reference gas points
             
+            //If SW0 was pressed
+            if (isPressed)
+            {
+                if (!SENSOR_CurvePointCapture(curveCalPPM[curvePoint]))
+                {
+                    //Bad reading, keep the existing curve
+                    LOG_0(LOG_CURVE_CAPTURE_FAILED);
+                    FUSA_SystemStateSet(SYS_MONITOR);
+                }
+                else if (++curvePoint < CURVE_CAL_POINTS)
+                {
+                    LOG_1(LOG_CURVE_NEXT, curveCalPPM[curvePoint]);
+                }
+                else if (SENSOR_CurveFit())
+                {
+                    LOG_0(LOG_CURVE_COMPLETE);
+                    FUSA_SystemStateSet(SYS_MONITOR);
+                }
+                else if (SENSOR_IsEEPROMValid())
+                {
+                    //Points could not be fit, nothing was written
+                    LOG_0(LOG_CURVE_FAILED);
+                    FUSA_SystemStateSet(SYS_MONITOR);
+                }
+                else
+                {
+                    //Something went wrong
+                    LOG_0(LOG_CALIBRATION_FAILED);
+                    FUSA_SystemStateSet(SYS_ERROR);
+                }
+            }
+            
+            break;
+        }
+        case SYS_MONITOR:
+        {
             //System is running
-            printf("[MONITOR] Estimated Ammonia: %d ppm\r\n", SENSOR_MeasurementConvert(meas));
+            for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+            {
+                lastPPM[ch] = SENSOR_MeasurementConvert(ch, meas[ch]);
+                
+                if (isTelemetryDue)
+                {
+                    LOG_2(LOG_MONITOR_PPM, ch, lastPPM[ch]);
+                }
+            }
             
             //Did the alarm activate?
-            if (SENSOR_IsTripped())
+            if (SENSOR_IsAnyTripped())
             {
                 //Activate the alarm and transition to a new state
                 FUSA_AlarmActivate();
                 
-                printf("Alarm is tripped!\r\n");
+                LOG_0(LOG_ALARM_TRIPPED);
             }
             else
             {
-                //Run self-test
-                if (!FUSA_ACTest())
+                //Compensate for slow sensor drift in clean air
+                for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
                 {
-                    printf("AC failed self-check.\r\n");
+                    SENSOR_BaselineTrack(ch, meas[ch]);
+                }
+                
+                //Result of the comparator test started on the last tick
+                if (ACTEST_ResultGet() == DIAG_FAIL)
+                {
+                    LOG_0(LOG_AC_ERROR);
                     FUSA_SystemStateSet(SYS_ERROR);
                 }
                 else if (isPressed)
                 {
                     //Re-calibrate
-                    printf("Ready to recalibrate. Press SW0 to set new zero-point.\r\n");
+                    LOG_0(LOG_RECALIBRATE);
                     FUSA_SystemStateSet(SYS_CALIBRATE);
                 }
                 else if (TEST_BUTTON_GetValue())
@@ -566,23 +927,34 @@ void FUSA_PeriodicSelfCheckRun(void)
                     //No errors, and request
                     FUSA_AlarmActivate();
                 }
+                else
+                {
+                    //Test the comparators in the background, finishes within microseconds
+                    ACTEST_Start();
+                }
             }
             break;
         }
         case SYS_ALARM:
         {
             //System alarm is tripped
-            LED0_Toggle();
-            
-            printf("[ALARM] Estimated Ammonia: %d ppm\r\n", SENSOR_MeasurementConvert(meas));
+            for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+            {
+                lastPPM[ch] = SENSOR_MeasurementConvert(ch, meas[ch]);
+                
+                if (isTelemetryDue)
+                {
+                    LOG_2(LOG_ALARM_PPM, ch, lastPPM[ch]);
+                }
+            }
             
-            //Did the alarm go off?
-            if (!SENSOR_IsTripped())
+            //Did the alarm go off on every channel?
+            if (!SENSOR_IsAnyTripped())
             {
                 //Deactivate the alarm and transition to SYS_MONITOR
                 FUSA_AlarmDeactivate();
                 
-                printf("Alarm has cleared!\r\n");
+                LOG_0(LOG_ALARM_CLEARED);
             }
             
             break;
@@ -602,6 +974,20 @@ void FUSA_PeriodicSelfCheckRun(void)
         }
 
     }
+    
+    //LED cadence of the new state
+    PATTERN_Play(_statePatternGet(sysState));
+    
+    //Verify the transition and the outputs of the new state
+    if (_stateInvariantVerify(prevState) != DIAG_PASS)
+    {
+        LOG_0(LOG_INVARIANT_ERROR);
+        FUSA_SystemStateSet(SYS_ERROR);
+    }
+    else
+    {
+        WATCHDOG_DiagComplete(WATCHDOG_DIAG_INVARIANT);
+    }
 }
 
 //Periodically scans the FLASH
@@ -610,7 +996,7 @@ void FUSA_PeriodicMemoryScanRun(void)
     if (!FUSA_FlashTest())
     {
         //Faulty FLASH
-        printf("FLASH has failed self test\r\n");
+        LOG_0(LOG_FLASH_ERROR);
         
 #ifndef DEVELOP_MODE
         FUSA_SystemStateSet(SYS_ERROR);
@@ -622,49 +1008,233 @@ void FUSA_PeriodicMemoryScanRun(void)
         //Verify EEPROM if in the run state
         if (!FUSA_EEPROMTest())
         {
-            printf("EERPOM has failed self test\r\n");
+            LOG_0(LOG_EEPROM_ERROR);
             
             FUSA_SystemStateSet(SYS_CALIBRATE);
         }
     }
 }
 
+//Checks the next segment of the FLASH
+void FUSA_PeriodicFlashSegmentRun(void)
+{
+    CPUCLK_Boost(CPUCLK_FLASH);
+    diag_result_t result = PFM_Service();
+    CPUCLK_Release(CPUCLK_FLASH);
+    
+    if (result != DIAG_PASS)
+    {
+        //Faulty FLASH, report the location
+        uint8_t segment = PFM_FailedSegmentGet();
+        LOG_2(LOG_FLASH_SEGMENT_ERROR, segment, PFM_SegmentAddressGet(segment));
+        
+#ifndef DEVELOP_MODE
+        FUSA_SystemStateSet(SYS_ERROR);
+        FUSA_HandleSystemFailure();
+#endif
+    }
+}
+
+//Periodically characterises AC1 while monitoring
+void FUSA_PeriodicACCharacterizeRun(void)
+{
+    if (acCharHours < ACCHAR_PERIOD_HOURS)
+    {
+        acCharHours++;
+    }
+    
+    //Due once a day, or when the setpoint has changed since the last run
+    bool isDue = (acCharHours >= ACCHAR_PERIOD_HOURS) || !ACCHAR_IsSetpointCharacterized();
+    
+    //AC1 is disconnected from the sensor for about 1ms, wait for a quiet hour
+    if (!isDue || (sysState != SYS_MONITOR) || SENSOR_IsAnyTripped())
+    {
+        return;
+    }
+    
+    acCharHours = 0;
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    //AC1 crosses the trip point, keep the buzzer quiet
+    ALARM_Arm(false);
+#endif
+    
+    FUSA_ACCharacterize();
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    ALARM_Arm((sysState == SYS_MONITOR) || (sysState == SYS_ALARM));
+#endif
+}
+
+//Runs additional SRAM sections while the tick started at tickStart is within budget
+void FUSA_SRAMSlackRun(uint32_t tickStart)
+{
+    const uint32_t budget = TIMING_US_TO_TICKS(FUSA_TICK_BUDGET_US);
+    uint8_t count = 0;
+    
+    //At most one full pass per tick, and only if the worst-case section still fits
+    while ((count < FUSA_SRAM_SECTIONS) && ((TIMING_ElapsedGet(tickStart) + sramSectionTicks) < budget))
+    {
+        if (_SRAMSectionRun() != DIAG_PASS)
+        {
+            LOG_0(LOG_SRAM_ERROR);
+            FUSA_SystemStateSet(SYS_ERROR);
+            return;
+        }
+        count++;
+    }
+}
+
+//Returns the time of the last full pass of SRAM (ms)
+uint32_t FUSA_SRAMCoverageTimeGet(void)
+{
+    return sramPassTime;
+}
+
+//Prints the SRAM March C- coverage
+void FUSA_SRAMCoveragePrint(void)
+{
+    printf("SRAM: %u / %u sections, full pass = %lu ms (worst %lu ms), section = %lu us\r\n",
+            sramSections, FUSA_SRAM_SECTIONS, sramPassTime, sramPassTimeWorst,
+            TIMING_TICKS_TO_US(sramSectionTicks));
+}
+
+//Prints the system state and the last concentrations
+void FUSA_StatusPrint(void)
+{
+    printf("State: %d\r\n", sysState);
+    
+    for (uint8_t ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++)
+    {
+        printf("CH%u: %u ppm\r\n", ch, lastPPM[ch]);
+    }
+}
+
+//Switches from monitoring to calibration, returns false if not monitoring
+bool FUSA_CalibrationRequest(void)
+{
+    if (sysState != SYS_MONITOR)
+    {
+        return false;
+    }
+    
+    LOG_0(LOG_RECALIBRATE);
+    FUSA_SystemStateSet(SYS_CALIBRATE);
+    
+    return true;
+}
+
+//Sets the number of ticks between telemetry messages (0 = off)
+void FUSA_TelemetryRateSet(uint16_t ticks)
+{
+    telemetryTicks = ticks;
+    telemetryCount = 0;
+}
+
+//Returns the number of ticks between telemetry messages
+uint16_t FUSA_TelemetryRateGet(void)
+{
+    return telemetryTicks;
+}
+
+//Prints the state machine transitions observed since start-up
+void FUSA_StateCoveragePrint(void)
+{
+    printf("State transitions observed:\r\n");
+    
+    for (uint8_t prev = SYS_WARMUP; prev < SYS_STATE_COUNT; prev++)
+    {
+        for (uint8_t next = SYS_WARMUP; next < SYS_STATE_COUNT; next++)
+        {
+            if (stateTransitions[prev] & SYS_STATE_BIT(next))
+            {
+                printf("  %u -> %u: %s\r\n", prev, next, (stateCoverage[prev] & SYS_STATE_BIT(next)) ? "yes" : "no");
+            }
+        }
+    }
+}
+
+//Disables the interrupts of everything except the timers, for the failure state
+static void _failureInterruptsDisable(void)
+{
+    PORT_t* const ports[] = {&PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF};
+    
+    //Buttons
+    for (uint8_t i = 0; i < (sizeof(ports) / sizeof(ports[0])); i++)
+    {
+        register8_t* pinCtrl = &ports[i]->PIN0CTRL;
+        
+        for (uint8_t pin = 0; pin < 8; pin++)
+        {
+            uint8_t isc = pinCtrl[pin] & PORT_ISC_gm;
+            if ((isc != PORT_ISC_INTDISABLE_gc) && (isc != PORT_ISC_INPUT_DISABLE_gc))
+            {
+                pinCtrl[pin] &= ~PORT_ISC_gm;
+            }
+        }
+    }
+    
+    //Hour / self-test ticks, UART commands, comparators, ADC and VLM
+    RTC.INTCTRL = 0;
+    RTC.PITINTCTRL = 0;
+    USART1.CTRLA &= ~USART_RXCIE_bm;
+    AC0.INTCTRL = 0;
+    AC1.INTCTRL = 0;
+    ADC0.INTCTRL = 0;
+    BOD.INTCTRL &= ~BOD_VLMIE_bm;
+}
+
 //Infinite loop for a system failure
 void FUSA_HandleSystemFailure(void)
 {
+    TRACE_Log(TRACE_FAILURE, (uint8_t) sysState);
+    
     //Disable interrupts
     cli();
     
     //Disable heater
-    HEATER_SetLow();
+    HEATER_Off();
+    
+    //Only the timers may wake the CPU from here
+    _failureInterruptsDisable();
     
-    //Variable used for printing the failure message
+    //Buzzer pattern, played by the timer interrupt
+    PATTERN_Play(PATTERN_FAULT);
+    
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sei();
+    
+    //Variables used for printing the failure message
     uint8_t timeCount = 10;
+    uint8_t lastCycle = PATTERN_CycleCountGet();
+    
+    LOG_0(LOG_SYSTEM_FAULT);
     
     while (1)
     {
+        //Sleep until the next step of the pattern
+        sleep_mode();
+        
+        if (PATTERN_CycleCountGet() == lastCycle)
+        {
+            continue;
+        }
+        
+        lastCycle = PATTERN_CycleCountGet();
+        
+        //Clear WDT - 800 ms per cycle is inside the open window
+        asm("WDR");
+        
         //Print a UART message every 10 cycles (~8s)
-        if (timeCount == 10)
+        if (timeCount == 1)
         {
-            printf("SYSTEM FAULT\r\n");
-            timeCount = 1;
+            LOG_0(LOG_SYSTEM_FAULT);
+            timeCount = 10;
         }
         else
         {
-            timeCount++;
+            timeCount--;
         }
-        
-        //Buzzer pattern
-        
-        BUZZER_ENABLE();
-        LED0_SetHigh();
-        DELAY_milliseconds(600);
-        LED0_SetLow();
-        BUZZER_DISABLE();
-        DELAY_milliseconds(200);
-        
-        //Clear WDT
-        asm("WDR");
     }
 }
 
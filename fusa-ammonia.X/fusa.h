@@ -30,6 +30,7 @@ extern "C" {
 #include <stdbool.h>
 
 #include "mcc_generated_files/system/pins.h"
+#include "mcc_generated_files/diagnostics/diag_common/config/diag_config.h"
     
 //How many bits above/below the DACREF should we test at 
 //Note - DAC0 is 10-bit, DACREF is 8-bit, so 4 bits at DAC0 = 1 bit at DACREF
@@ -39,12 +40,40 @@ extern "C" {
 //#define VIEW_RAW_ADC
     
 #define TEST_BUTTON_GetValue T1OUT_GetValue
+    
+//Prints the SRAM March C- coverage every hour
+//#define PRINT_SRAM_COVERAGE
+    
+//Prints the state machine transitions observed every hour
+//#define PRINT_STATE_COVERAGE
+    
+//Time each 0.5s tick may spend on the periodic tasks, including extra SRAM sections (us)
+#define FUSA_TICK_BUDGET_US 100000UL
+    
+//If defined, faults are injected into the diagnosed variables / registers to measure detection (develop builds only)
+//#define FUSA_FAULT_INJECTION
+    
+//Number of SRAM sections tested by DIAG_SRAM_MarchPeriodic() for a full pass of SRAM
+#define FUSA_SRAM_SECTIONS ((DIAG_SRAM_DATA_REGION_LEN - DIAG_SRAM_MARCH_SEC_OVERLAP) / \
+                            (DIAG_SRAM_MARCH_SEC_SIZE - DIAG_SRAM_MARCH_SEC_OVERLAP))
         
     typedef enum {
         SYS_ERROR = -1, SYS_INIT = 0, SYS_WARMUP, 
-        SYS_CALIBRATE, SYS_MONITOR, SYS_SELF_TEST, SYS_ALARM
+        SYS_CALIBRATE, SYS_MONITOR, SYS_SELF_TEST, SYS_ALARM,
+        SYS_CALIBRATE_CURVE
     } system_state_t;
     
+    //Sets the system state
+    void FUSA_SystemStateSet(system_state_t state);
+    
+    //Returns the system state
+    system_state_t FUSA_SystemStateGet(void);
+    
+#ifdef FUSA_FAULT_INJECTION
+    //Flips bits of the system state, or of its verification copy
+    void FUSA_StateFaultInject(uint8_t mask, bool isCheck);
+#endif
+    
     //Runs a self-test of the system on startup
     bool FUSA_StartupSelfTestRun(void);
     
@@ -57,6 +86,9 @@ extern "C" {
     //Test the comparator
     bool FUSA_ACTest(void);
     
+    //Characterise AC1, and tighten the comparator test
+    bool FUSA_ACCharacterize(void);
+    
     //Run a memory self-test
     bool FUSA_FlashTest(void);
     
@@ -78,6 +110,36 @@ extern "C" {
     //Periodically scans the FLASH
     void FUSA_PeriodicMemoryScanRun(void);
     
+    //Checks the next segment of the FLASH
+    void FUSA_PeriodicFlashSegmentRun(void);
+    
+    //Periodically characterises AC1 while monitoring
+    void FUSA_PeriodicACCharacterizeRun(void);
+    
+    //Runs additional SRAM sections while the tick started at tickStart is within budget
+    void FUSA_SRAMSlackRun(uint32_t tickStart);
+    
+    //Returns the time of the last full pass of SRAM (ms)
+    uint32_t FUSA_SRAMCoverageTimeGet(void);
+    
+    //Prints the SRAM March C- coverage
+    void FUSA_SRAMCoveragePrint(void);
+    
+    //Prints the state machine transitions observed since start-up
+    void FUSA_StateCoveragePrint(void);
+    
+    //Prints the system state and the last concentrations
+    void FUSA_StatusPrint(void);
+    
+    //Switches from monitoring to calibration, returns false if not monitoring
+    bool FUSA_CalibrationRequest(void);
+    
+    //Sets the number of ticks between telemetry messages (0 = off)
+    void FUSA_TelemetryRateSet(uint16_t ticks);
+    
+    //Returns the number of ticks between telemetry messages
+    uint16_t FUSA_TelemetryRateGet(void);
+    
     //Infinite loop for a system failure
     void FUSA_HandleSystemFailure(void);
     
@@ -30,10 +30,29 @@
     EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
     THIS SOFTWARE.
 */
+#include <avr/sleep.h>
 #include "mcc_generated_files/system/system.h"
 #include "mcc_generated_files/timer/delay.h"
 #include "fusa.h"
 #include "application.h"
+#include "SENSOR.h"
+#include "TIMING.h"
+#include "ENV.h"
+#include "HEATER.h"
+#include "WATCHDOG.h"
+#include "TRACE.h"
+#include "STACK.h"
+#include "FAULT.h"
+#include "CONSOLE.h"
+#include "PFM.h"
+#include "EVENT.h"
+#include "PATTERN.h"
+#include "ACTEST.h"
+#include "ACCHAR.h"
+#include "WARMUP.h"
+#include "POWERFAIL.h"
+#include "BOOT.h"
+#include "CPUCLK.h"
 #include "mcc_generated_files/reset/rstctrl.h"
 #include "mcc_generated_files/diagnostics/diag_library/memory/volatile/diag_sram_marchc_minus.h"
 #include "mcc_generated_files/diagnostics/diag_library/wdt/diag_wdt_startup.h"
@@ -84,16 +103,170 @@ void printResetReasons(void)
     RSTCTRL_clear_reset_cause();
 }
 
-static volatile bool memoryScan = false;
-
 void requestMemoryVerification(void)
 {
-    memoryScan = true;
+    EVENT_Post(EVENT_MEMORY_SCAN, 0);
+}
+
+//Runs the memory scan
+static void memoryScanRun(void)
+{
+    TRACE_StageSet(TRACE_STAGE_MEMORY_SCAN);
+    TRACE_Log(TRACE_MEMORY_SCAN, 0);
+    FUSA_PeriodicMemoryScanRun();
+    TRACE_Log(TRACE_MEMORY_SCAN, 1);
+    printf("Memory self test complete\r\n");
+}
+
+//Runs the periodic self-check and services the application, once per PIT tick
+static void tickRun(uint32_t tickStart)
+{
+    //Run periodic self-check
+    FUSA_PeriodicSelfCheckRun();
+    
+    //Advance the heater profile
+    TRACE_StageSet(TRACE_STAGE_HEATER_SERVICE);
+    HEATER_Service();
+    
+    //Checkpoint the warm-up progress
+    TRACE_StageSet(TRACE_STAGE_WARMUP);
+    WARMUP_Service();
+    
+    //Update the temperature / humidity compensation, after the alarm checks
+    TRACE_StageSet(TRACE_STAGE_ENV);
+    if (ENV_Service())
+    {
+        SENSOR_EnvironmentUpdate();
+    }
+    
+    //Check the next segment of the FLASH against its CRC
+    TRACE_StageSet(TRACE_STAGE_FLASH_SEGMENT);
+    FUSA_PeriodicFlashSegmentRun();
+    
+    //Use the remaining time in this tick to test more of SRAM
+    TRACE_StageSet(TRACE_STAGE_SRAM_SLACK);
+    FUSA_SRAMSlackRun(tickStart);
+    
+    //Run any command received over UART
+    TRACE_StageSet(TRACE_STAGE_CONSOLE);
+    CONSOLE_Service();
+    
+#ifdef FUSA_FAULT_INJECTION
+    //Inject the next fault, after the diagnostics of this tick
+    FAULT_Service();
+#endif
+    
+    //Clear the WDT once all diagnostics of this tick are complete
+    TRACE_StageSet(TRACE_STAGE_WDT_KICK);
+    WATCHDOG_Kick();
+}
+
+//Runs the hourly memory scan and reports
+static void hourRun(void)
+{
+    if (FUSA_SystemStateGet() == SYS_WARMUP)
+    {
+        APP_RemainingHoursPrint();
+    }
+    
+    //Run memory scan
+    memoryScanRun();
+    
+    //Store the drift compensated baselines once per day
+    SENSOR_BaselineHourTick();
+    
+    //Track the trip point and response time of AC1
+    FUSA_PeriodicACCharacterizeRun();
+    
+    //Format the reports at the boosted clock
+    CPUCLK_Boost(CPUCLK_PRINT);
+    
+#ifdef PRINT_CHANNEL_STATS
+    SENSOR_ChannelStatsPrint();
+#endif
+    
+#ifdef PRINT_HEATER_STATS
+    HEATER_StatsPrint();
+#endif
+    
+#ifdef PRINT_SRAM_COVERAGE
+    FUSA_SRAMCoveragePrint();
+#endif
+    
+#ifdef PRINT_WDT_HISTOGRAM
+    WATCHDOG_HistogramPrint();
+#endif
+    
+#ifdef PRINT_STACK_USAGE
+    STACK_UsagePrint();
+#endif
+    
+#ifdef PRINT_STATE_COVERAGE
+    FUSA_StateCoveragePrint();
+#endif
+    
+#ifdef PRINT_EVENT_STATS
+    EVENT_StatsPrint();
+#endif
+    
+#ifdef PRINT_AC_TEST_STATS
+    ACTEST_StatsPrint();
+#endif
+    
+#ifdef PRINT_CLOCK_STATS
+    CPUCLK_StatsPrint();
+#endif
+    
+    CPUCLK_Release(CPUCLK_PRINT);
 }
 
 int main(void)
 {
     SYSTEM_Initialize();
+    
+    //Profile the start-up, until the self-test is complete
+    BOOT_Initialize();
+    
+    //Start the timebase for execution time measurements
+    TIMING_Initialize();
+    
+    //Clock boost for the heavy diagnostics, from the UART baud rate at F_CPU
+    CPUCLK_Initialize();
+    
+    //Start the LED / buzzer pattern sequencer
+    PATTERN_Initialize();
+    
+    //Start measuring the WDT kick intervals
+    WATCHDOG_Initialize();
+    
+    //Start the high-water scan of the stack painted at start-up
+    STACK_Initialize();
+    
+    //Start the segmented FLASH scan
+    PFM_Initialize();
+    
+    //Start with an empty event queue
+    EVENT_Initialize();
+    
+#ifdef FUSA_FAULT_INJECTION
+    //Inject faults once the system is monitoring
+    FAULT_CampaignStart();
+#endif
+    
+    //Set up the comparators of any additional sensor channels
+    APP_ComparatorsInitialize();
+    
+#ifdef FUSA_ENABLE_HW_ALARM
+    //Route AC1 to the buzzer through EVSYS and the CCL
+    ALARM_Initialize();
+#endif
+    
+    //Default margin / settling time of the comparator test, and the AC1 capture for characterisation
+    ACTEST_Initialize();
+    ACCHAR_Initialize();
+    
+    //Measure the temperature / humidity for the sensor compensation
+    ENV_Initialize();
         
     //Interrupt callback for an hour passing
     RTC_SetOVFIsrCallback(&APP_HourTick);
@@ -107,55 +280,99 @@ int main(void)
     //Interrupt callback for Button 3 - Memory Verification
     T3OUT_SetInterruptHandler(&requestMemoryVerification);
     
+    //UART commands
+    CONSOLE_SetMemoryScanHandler(&requestMemoryVerification);
+    CONSOLE_Initialize();
+    
     printf("AVR64EA48 Ammonia Gas Functional Safety Demo\r\n");
     printf("Built %s at %s\r\n", __DATE__, __TIME__);
     printResetReasons();
     
+    //Dump the trace from before the reset, and start a new one
+    TRACE_Initialize(DIAG_WDT_GetRSTFRCopy());
+    
+    //Find the warm-up progress from before the reset
+    WARMUP_Initialize(DIAG_WDT_GetRSTFRCopy());
+    
 #ifdef DEVELOP_MODE
     printf("WARNING: Device is in develop mode. System will power-up if errors occur and skip sensor warm-up period.\r\nDO NOT USE FOR PRODUCTION\r\n");
 #endif
     
-    //Run system self-test
+    //Run system self-test, which starts the sensor heater with the pre-heat profile
     FUSA_StartupSelfTestRun();
-            
-    //Start the sensor heater
-    HEATER_SetHigh();
+    
+    //Credit the warm-up from before the reset, by the heater off time
+    WARMUP_Restore();
+    
+    //Shed the load and save the warm-up progress if VDD falls
+    POWERFAIL_Initialize();
+    
+    //Sleep between events, all peripherals run in idle
+    set_sleep_mode(SLEEP_MODE_IDLE);
     
     //Enable interrupts
     sei();
     
-    //Clear self-test flag
-    APP_SelfTestFlashClear();
+#ifdef PRINT_BOOT_PROFILE
+    BOOT_Print();
+#endif
     
     while(1)
-    {        
-        //Do we need to self test and clear WDT?
-        if (APP_IsReadyForSelfTest())
-        {            
-            //Clear self-test flag
-            APP_SelfTestFlashClear();
-            
-            //Run periodic self-check
-            FUSA_PeriodicSelfCheckRun();
+    {
+        event_t event;
+        
+        //Dispatch the events posted by the interrupts, oldest first
+        while (EVENT_Get(&event))
+        {
+            EVENT_LatencyUpdate(&event);
             
-            if (APP_HasHourTicked())
+            switch (event.type)
             {
-                //Clear hour tick
-                APP_HourTickClear();
-                
-                //Run memory scan
-                FUSA_PeriodicMemoryScanRun();
-                printf("Memory self test complete\r\n");
-            }
-            else if (memoryScan)
-            {
-                //User requested memory validation
-                memoryScan = false;
-                
-                //Run memory scan
-                FUSA_PeriodicMemoryScanRun();
-                printf("Memory self test complete\r\n");
+                case EVENT_TICK:
+                {
+                    uint32_t start = TIMING_TimestampGet();
+                    
+                    //The tick budget starts when the PIT fired
+                    tickRun(event.time);
+                    
+                    //Busy time, for the charge per tick
+                    CPUCLK_TickRecord(TIMING_ElapsedGet(start));
+                    break;
+                }
+                case EVENT_HOUR:
+                {
+                    hourRun();
+                    break;
+                }
+                case EVENT_MEMORY_SCAN:
+                {
+                    //User requested memory validation
+                    memoryScanRun();
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
             }
+            
+            TRACE_StageSet(TRACE_STAGE_IDLE);
+        }
+        
+        //Sleep until the next interrupt, unless one posted an event after the queue was emptied
+        cli();
+        if (EVENT_IsPending())
+        {
+            sei();
+        }
+        else
+        {
+            sleep_enable();
+            
+            //SEI is followed by one more instruction before an interrupt, so the wake-up is not missed
+            sei();
+            sleep_cpu();
+            sleep_disable();
         }
     }    
 }
\ No newline at end of file
@@ -155,7 +155,8 @@
  @ref DIAG_SRAM_MarchStartup(). Setting the macro to zero will result in using 
  the default/reset frequency during execution of the SRAM march test at startup.
 */
-#define DIAG_SRAM_MARCH_ALT_CLK_FRQ_ENABLED (0U)
+//Manual edit after generation (0U in the MCC configuration), see CPUCLK.h
+#define DIAG_SRAM_MARCH_ALT_CLK_FRQ_ENABLED (1U)
 
 #if defined (__DOXYGEN__)
 /**
@@ -75,13 +75,7 @@ int8_t BOD_Initialize()
     return 0;
 }
 
-ISR(BOD_VLM_vect)
-{
-	/* Insert your AC interrupt handling code here */
-
-	/* The interrupt flag has to be cleared manually */
-	BOD.INTFLAGS = BOD_VLMIE_bm;
-}
+/* BOD_VLM_vect is handled by POWERFAIL.c - remove this ISR again after regenerating */
 
 int8_t WDT_Initialize()
 {
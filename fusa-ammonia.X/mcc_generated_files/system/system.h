@@ -63,6 +63,10 @@ extern "C" {
 */
 void SYSTEM_Initialize(void);
 
+/* Hand edit: the BOD_VLM_vect ISR is removed from system.c, POWERFAIL.c handles the vector.
+ * Regenerating drops this define, and POWERFAIL.c stops the build until the ISR is removed again. */
+#define SYSTEM_BOD_VLM_ISR_REMOVED
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""Post-link flash CRC tool for the demo.
+
+Reads the Intel HEX image, fills the unused flash, computes the CRC-32 of the
+application region and patches it in at the reference address, little endian.
+The value is checked by the Class B library (DIAG_FLASH_ValidateCRC,
+diag_crc32_lookup_table). No reference is computed for the CRCSCAN hardware,
+so the build fails if FUSA_ENABLE_FLASH_HW_SCAN is defined in application.h.
+
+The application region below the table is also split into fixed-size
+segments. The CRC-32 of every segment is written to a table just below the
+flash CRC, checked one segment at a time by PFM.c, and listed in the region
+map written with --map.
+
+Usage: flash_crc.py <image.hex> [-o out.hex] [--map file] [--check] [--config application.h]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+#Must match diag_config.h and CRC_ADDRESS_START in fusa.c
+FLASH_START = 0x0000
+FLASH_CRC_ADDR = 0xFFFC
+FLASH_SIZE = 0x10000
+FLASH_FILL = 0xFF
+
+#CRC-32 (IEEE 802.3), as diag_crc32_lookup_table.c / CRC32_INITIAL_SEED / CRC32_FINAL_XOR_VALUE
+CRC32_POLY_REFLECTED = 0xEDB88320
+CRC32_INITIAL_SEED = 0xFFFFFFFF
+CRC32_FINAL_XOR_VALUE = 0xFFFFFFFF
+
+#Hardware flash scan option, not supported by this tool
+HW_SCAN_MACRO = "FUSA_ENABLE_FLASH_HW_SCAN"
+HW_SCAN_CONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "application.h")
+
+#Must match PFM.h
+SEGMENT_SIZE = 2048
+SEGMENT_COUNT = 32
+SEGMENT_TABLE_ADDR = FLASH_CRC_ADDR - (4 * SEGMENT_COUNT)
+
+
+def _crc32_table():
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ CRC32_POLY_REFLECTED if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+CRC32_TABLE = _crc32_table()
+
+
+def crc32(data, crc=CRC32_INITIAL_SEED):
+    """Software CRC-32, same algorithm as DIAG_FLASH_CalculateCRC."""
+    for byte in data:
+        crc = CRC32_TABLE[(byte ^ crc) & 0xFF] ^ (crc >> 8)
+    return crc ^ CRC32_FINAL_XOR_VALUE
+
+
+def hw_scan_enabled(path):
+    """Returns true if the hardware flash scan is defined (not commented out) in the header."""
+    with open(path, encoding="latin-1") as f:
+        return any(re.match(r"\s*#\s*define\s+%s\b" % HW_SCAN_MACRO, line) for line in f)
+
+
+def hex_read(path):
+    """Returns the data of the image as {address: byte}, and the start address records."""
+    memory = {}
+    extra = []
+    base = 0
+
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                continue
+            if not line.startswith(":"):
+                raise ValueError("%s:%u: not an Intel HEX record" % (path, number))
+
+            record = bytes.fromhex(line[1:])
+            if (sum(record) & 0xFF) != 0:
+                raise ValueError("%s:%u: bad record checksum" % (path, number))
+
+            count, addr, kind = record[0], (record[1] << 8) | record[2], record[3]
+            data = record[4:4 + count]
+
+            if kind == 0x00:
+                for i, byte in enumerate(data):
+                    memory[base + addr + i] = byte
+            elif kind == 0x01:
+                break
+            elif kind == 0x02:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif kind == 0x04:
+                base = ((data[0] << 8) | data[1]) << 16
+            else:
+                extra.append(record)
+
+    return memory, extra
+
+
+def _record(kind, addr, data):
+    record = bytes([len(data), (addr >> 8) & 0xFF, addr & 0xFF, kind]) + bytes(data)
+    return ":%s%02X" % (record.hex().upper(), (-sum(record)) & 0xFF)
+
+
+def hex_write(path, memory, extra):
+    """Writes the image, 16 bytes per record."""
+    lines = []
+    upper = None
+    addrs = sorted(memory)
+    i = 0
+
+    while i < len(addrs):
+        start = addrs[i]
+        data = [memory[start]]
+        i += 1
+        while (i < len(addrs)) and (addrs[i] == start + len(data)) and (len(data) < 16) \
+                and ((addrs[i] & 0xFFFF) != 0):
+            data.append(memory[addrs[i]])
+            i += 1
+
+        if (start >> 16) != upper:
+            upper = start >> 16
+            lines.append(_record(0x04, 0, [(upper >> 8) & 0xFF, upper & 0xFF]))
+        lines.append(_record(0x00, start & 0xFFFF, data))
+
+    for record in extra:
+        lines.append(_record(record[3], (record[1] << 8) | record[2], record[4:-1]))
+    lines.append(_record(0x01, 0, []))
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+def region_get(memory, start, end):
+    return bytes(memory.get(addr, FLASH_FILL) for addr in range(start, end))
+
+
+def segments_get(memory):
+    """Returns (start, end, CRC-32) of every segment of the application region."""
+    segments = []
+    for start in range(FLASH_START, SEGMENT_TABLE_ADDR, SEGMENT_SIZE):
+        end = min(start + SEGMENT_SIZE, SEGMENT_TABLE_ADDR)
+        segments.append((start, end, crc32(region_get(memory, start, end))))
+
+    if len(segments) != SEGMENT_COUNT:
+        raise ValueError("SEGMENT_SIZE / SEGMENT_COUNT do not cover the application region")
+
+    return segments
+
+
+def map_write(path, segments):
+    """Writes the CRC-32 of every segment of the application region."""
+    with open(path, "w") as f:
+        f.write("#segment start end crc32 (table @ 0x%04X)\n" % SEGMENT_TABLE_ADDR)
+        for index, (start, end, crc) in enumerate(segments):
+            f.write("%3u 0x%04X 0x%04X 0x%08X\n" % (index, start, end - 1, crc))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", help="Intel HEX image from the linker")
+    parser.add_argument("-o", "--output", help="patched image (default: overwrite the input)")
+    parser.add_argument("--map", help="write the region map to this file")
+    parser.add_argument("--check", action="store_true", help="only verify the stored CRC")
+    parser.add_argument("--config", default=HW_SCAN_CONFIG, help="header with %s (default: application.h)" % HW_SCAN_MACRO)
+    args = parser.parse_args()
+
+    #The CRCSCAN reference is not computed, the hardware scan would fail on the device
+    if hw_scan_enabled(args.config):
+        print("Flash CRC: %s is not supported, no CRCSCAN reference is computed" % HW_SCAN_MACRO, file=sys.stderr)
+        return 1
+
+    memory, extra = hex_read(args.image)
+
+    #Erased flash reads 0xFF
+    raw = region_get(memory, FLASH_CRC_ADDR, FLASH_CRC_ADDR + 4)
+    stored = None if raw == bytes([FLASH_FILL] * 4) else int.from_bytes(raw, "little")
+
+    segments = segments_get(memory)
+
+    if args.check:
+        for index, (start, end, crc) in enumerate(segments):
+            addr = SEGMENT_TABLE_ADDR + (4 * index)
+            if int.from_bytes(region_get(memory, addr, addr + 4), "little") != crc:
+                print("Flash CRC: segment %u (0x%04X) does not match the table" % (index, start), file=sys.stderr)
+                return 1
+
+        crc = crc32(region_get(memory, FLASH_START, FLASH_CRC_ADDR))
+        if stored != crc:
+            print("Flash CRC: stored = %s, expected 0x%08X" %
+                  ("none" if stored is None else "0x%08X" % stored, crc), file=sys.stderr)
+            return 1
+    else:
+        #Cross-check the CRC from hexmate, before the segment table is added
+        if (stored is not None) and (stored != crc32(region_get(memory, FLASH_START, FLASH_CRC_ADDR))):
+            print("Flash CRC: stored 0x%08X does not match the image" % stored, file=sys.stderr)
+            return 1
+
+        #Fill the unused flash, so the image matches the device after programming
+        for addr in range(FLASH_START, FLASH_SIZE):
+            memory.setdefault(addr, FLASH_FILL)
+
+        #The segment table is covered by the flash CRC
+        for index, (start, end, segment_crc) in enumerate(segments):
+            for i, byte in enumerate(segment_crc.to_bytes(4, "little")):
+                memory[SEGMENT_TABLE_ADDR + (4 * index) + i] = byte
+
+        crc = crc32(region_get(memory, FLASH_START, FLASH_CRC_ADDR))
+        for i, byte in enumerate(crc.to_bytes(4, "little")):
+            memory[FLASH_CRC_ADDR + i] = byte
+
+    print("Flash CRC = 0x%08X (0x%04X - 0x%04X @ 0x%04X)" % (crc, FLASH_START, FLASH_CRC_ADDR - 1, FLASH_CRC_ADDR))
+
+    if not args.check:
+        hex_write(args.output or args.image, memory, extra)
+
+    if args.map:
+        map_write(args.map, segments)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Decodes the tokenized log of the demo (LOG_TOKENIZED in LOG.h).
+
+Text is passed through unchanged. Tokenized messages are:
+    0xFF, ID (16-bit), argument count, arguments (32-bit each), all little endian
+
+Usage: log_decode.py <serial port | capture file> [path to LOG.h]
+"""
+
+import os
+import re
+import struct
+import sys
+
+LOG_SYNC = 0xFF
+
+
+def load_formats(header):
+    """Reads the message table from LOG.h, in ID order."""
+    with open(header, encoding="latin-1") as f:
+        text = f.read()
+
+    entries = re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', text)
+    formats = []
+    for name, fmt in entries:
+        fmt = fmt.encode("latin-1").decode("unicode_escape")
+        #Printf length modifiers are not used by Python
+        fmt = re.sub(r"%([-0-9.]*)l+([diuxX])", r"%\1\2", fmt)
+        fmt = re.sub(r"%([-0-9.]*)u", r"%\1d", fmt)
+        formats.append((name, fmt))
+
+    return formats
+
+
+def decode(stream, formats, out):
+    """Decodes the stream until the end of the file."""
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            return
+
+        if byte[0] != LOG_SYNC:
+            out.write(byte.decode("latin-1"))
+            continue
+
+        header = stream.read(3)
+        if len(header) < 3:
+            return
+
+        msg_id, count = struct.unpack("<HB", header)
+        args = struct.unpack("<%dI" % count, stream.read(4 * count))
+
+        if msg_id >= len(formats):
+            out.write("<unknown log ID %u: %s>\r\n" % (msg_id, args))
+            continue
+
+        name, fmt = formats[msg_id]
+        try:
+            out.write(fmt % args)
+        except (TypeError, ValueError):
+            out.write("<%s: %s>\r\n" % (name, args))
+
+        out.flush()
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+
+    header = sys.argv[2] if len(sys.argv) > 2 else \
+        os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "LOG.h")
+
+    formats = load_formats(header)
+
+    with open(sys.argv[1], "rb", buffering=0) as stream:
+        decode(stream, formats, sys.stdout)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())